@@ -0,0 +1,144 @@
+// functions to build, parse and print ack_bitmap messages.
+
+#include <Arduino.h>
+
+#include "ack_bitmap.h"
+
+/**
+ * @brief Start an empty ack_bitmap
+ * @param acks Pointer to the message
+ * @param node The main node's node number
+ * @param time The current time
+ */
+void build_ack_bitmap(ack_bitmap_t *acks, const uint8_t node, const uint32_t time) {
+    acks->type = ack_bitmap;
+    acks->node = node;
+    acks->time = time;
+    acks->count = 0;
+}
+
+/**
+ * @brief Acknowledge a message from a leaf node
+ *
+ * A message newer than the entry's newest becomes the newest and the
+ * bitmap slides along; messages that fall out of the window are no
+ * longer acknowledged, so the leaf will send them again.
+ *
+ * @param acks The message
+ * @param leaf_node The node that sent the message
+ * @param message Its message number
+ * @return true if the message is acknowledged, false if the ack_bitmap
+ * is full or the message is too far behind the node's newest. In that
+ * case, send this ack_bitmap and start another.
+ */
+bool add_ack_bitmap_entry(ack_bitmap_t *acks, const uint8_t leaf_node, const uint32_t message) {
+    ack_entry_t *e = 0;
+    for (uint8_t i = 0; i < acks->count; ++i) {
+        if (acks->acks[i].node == leaf_node) {
+            e = &acks->acks[i];
+            break;
+        }
+    }
+
+    if (!e) {
+        if (acks->count >= ACK_BITMAP_MAX_ENTRIES)
+            return false;
+        e = &acks->acks[acks->count++];
+        e->node = leaf_node;
+        e->message = (uint16_t)message;
+        e->bitmap = 0;
+        return true;
+    }
+
+    int16_t ahead = (int16_t)((uint16_t)message - e->message);
+    if (ahead > 0) {
+        e->bitmap = ahead > ACK_BITMAP_WINDOW ? 0 : (uint8_t)((e->bitmap << ahead) | (1 << (ahead - 1)));
+        e->message = (uint16_t)message;
+    }
+    else if (ahead < 0) {
+        if (-ahead > ACK_BITMAP_WINDOW)
+            return false;
+        e->bitmap |= (uint8_t)(1 << (-ahead - 1));
+    }
+
+    return true;
+}
+
+/**
+ * @brief extract the header information from an ack_bitmap message
+ * @param acks The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the main node's node number
+ * @param time If not null, returns the time
+ * @param count If not null, returns the number of entries
+ * @return true if this is an ack_bitmap message, false otherwise.
+ */
+bool parse_ack_bitmap(const ack_bitmap_t *acks, uint8_t len, uint8_t *node, uint32_t *time, uint8_t *count) {
+    if (len < ACK_BITMAP_HEADER_SIZE || get_message_type(acks) != ack_bitmap || acks->count > ACK_BITMAP_MAX_ENTRIES
+        || !check_message_frame(acks, len, ACK_BITMAP_SIZE(acks)))
+        return false;
+
+    if (node)
+        *node = acks->node;
+    if (time)
+        *time = acks->time;
+    if (count)
+        *count = acks->count;
+
+    return true;
+}
+
+/**
+ * @brief Does one entry acknowledge a message?
+ * @param newest The entry's newest message number, low 16 bits
+ * @param bitmap The entry's bitmap
+ * @param message The message number
+ * @return true if the message is acknowledged
+ */
+bool ack_entry_acks(uint16_t newest, uint8_t bitmap, const uint32_t message) {
+    int16_t behind = (int16_t)(newest - (uint16_t)message);
+    if (behind == 0)
+        return true;
+
+    return behind > 0 && behind <= ACK_BITMAP_WINDOW && (bitmap & (1 << (behind - 1)));
+}
+
+/**
+ * @brief Does an ack_bitmap acknowledge a leaf node's message?
+ * @param acks The message
+ * @param leaf_node The leaf node
+ * @param message The message number to look for
+ * @return true if the message is acknowledged, false otherwise.
+ */
+bool ack_bitmap_acks(const ack_bitmap_t *acks, const uint8_t leaf_node, const uint32_t message) {
+    if (get_message_type(acks) != ack_bitmap)
+        return false;
+
+    for (uint8_t i = 0; i < acks->count && i < ACK_BITMAP_MAX_ENTRIES; ++i) {
+        if (acks->acks[i].node == leaf_node)
+            return ack_entry_acks(acks->acks[i].message, acks->acks[i].bitmap, message);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Write a string representation for the header of an ack_bitmap
+ * @param acks The message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t ack_bitmap_to_string(const ack_bitmap_t *acks, char *buf, size_t len, bool pretty /* false */) {
+    int n;
+    if (pretty) {
+        n = snprintf(buf, len, "node: %u, time: %lu, entries: %u", acks->node, (unsigned long)acks->time,
+                     acks->count);
+    }
+    else {
+        n = snprintf(buf, len, "%u, %lu, %u", acks->node, (unsigned long)acks->time, acks->count);
+    }
+
+    return written_length(n, len);
+}
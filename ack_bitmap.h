@@ -0,0 +1,62 @@
+/**
+ * A broadcast from the main node that acknowledges data from many leaf
+ * nodes at once and carries the current time.
+ *
+ * Instead of an ACK per data packet and a time response per time
+ * request, the main node collects what it has received with
+ * add_ack_bitmap_entry() and sends one ack_bitmap, e.g., at the end of
+ * each TDMA frame (see slot_schedule.h). Each entry covers one leaf node:
+ * the low 16 bits of the newest message number received from it, and a
+ * bitmap of which of the ACK_BITMAP_WINDOW messages before that were
+ * also received. A leaf that sent with RHDatagram (no per-packet ACK)
+ * checks its messages with ack_bitmap_acks() and passes the time to
+ * time_sync_update() (see time_sync.h).
+ */
+
+#ifndef h_ack_bitmap_h
+#define h_ack_bitmap_h
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+
+#include "wire_format.h"
+#include "messages.h"
+
+/// Messages before the newest one that an entry can acknowledge
+#define ACK_BITMAP_WINDOW 8
+
+struct ack_entry_t {
+    uint8_t node;       // leaf node number
+    uint16_t message;   // low 16 bits of the newest message number
+    uint8_t bitmap;     // bit i == message - 1 - i was received
+} PACKED;
+
+/// Size of the ack_bitmap header in bytes
+#define ACK_BITMAP_HEADER_SIZE (sizeof(ack_bitmap_t) - sizeof(ack_bitmap_t::acks))
+
+/// The most entries that fit in one radio frame; one fewer with a CRC trailer
+#define ACK_BITMAP_MAX_ENTRIES 61
+
+struct ack_bitmap_t {
+    MessageType type;   // ack_bitmap
+    uint8_t node;       // From
+    uint32_t time;      // Unix time
+    uint8_t count;      // Number of entries
+    ack_entry_t acks[ACK_BITMAP_MAX_ENTRIES];
+} PACKED;
+
+static_assert(sizeof(ack_entry_t) == 4, "ack_entry_t wire layout changed");
+static_assert(ACK_BITMAP_HEADER_SIZE == 7, "ack_bitmap_t wire layout changed");
+static_assert(sizeof(ack_bitmap_t) <= RH_RF95_MAX_MESSAGE_LEN, "ack_bitmap_t does not fit in one radio frame");
+
+/// The number of bytes to send for an ack_bitmap
+#define ACK_BITMAP_SIZE(a) (ACK_BITMAP_HEADER_SIZE + (a)->count * sizeof(ack_entry_t))
+
+void build_ack_bitmap(ack_bitmap_t *acks, const uint8_t node, const uint32_t time);
+bool add_ack_bitmap_entry(ack_bitmap_t *acks, const uint8_t leaf_node, const uint32_t message);
+bool parse_ack_bitmap(const ack_bitmap_t *acks, uint8_t len, uint8_t *node, uint32_t *time, uint8_t *count);
+bool ack_bitmap_acks(const ack_bitmap_t *acks, const uint8_t leaf_node, const uint32_t message);
+bool ack_entry_acks(uint16_t newest, uint8_t bitmap, const uint32_t message);
+size_t ack_bitmap_to_string(const ack_bitmap_t *acks, char *buf, size_t len, bool pretty = false);
+
+#endif
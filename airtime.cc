@@ -0,0 +1,31 @@
+// LoRa time on air.
+
+#include <Arduino.h>
+
+#include "airtime.h"
+
+/**
+ * @brief How long a message takes to send
+ * @param len The number of bytes passed to RH_RF95::send(), including any
+ * CRC trailer
+ * @param spreading_factor 6 - 12
+ * @param bandwidth The signal bandwidth, Hz, e.g., 125000
+ * @return The time on air in microseconds, preamble and headers included
+ */
+uint32_t lora_airtime_us(uint8_t len, uint8_t spreading_factor /* LORA_DEFAULT_SF */,
+                         uint32_t bandwidth /* LORA_DEFAULT_BANDWIDTH */) {
+    const int32_t sf = spreading_factor;
+    const int32_t payload = len + LORA_RH_HEADER_SIZE;
+
+    // Symbols longer than 16 ms need low data rate optimization
+    const int32_t de = ((uint64_t)1000 << sf) > (uint64_t)16 * bandwidth ? 1 : 0;
+
+    // Payload symbols beyond the first 8, with a CRC (16) and an explicit header (0)
+    int32_t bits = 8 * payload - 4 * sf + 28 + 16;
+    int32_t blocks = bits > 0 ? (bits + 4 * (sf - 2 * de) - 1) / (4 * (sf - 2 * de)) : 0;
+
+    // In quarter symbols: the preamble plus 4.25 for the sync word, then the payload
+    uint32_t quarters = 4 * LORA_PREAMBLE_SYMBOLS + 17 + 4 * (8 + blocks * 5);
+
+    return (uint32_t)(((uint64_t)quarters << sf) * 1000000 / (4 * (uint64_t)bandwidth));
+}
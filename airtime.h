@@ -0,0 +1,34 @@
+/**
+ * Estimated LoRa time on air for a frame.
+ *
+ * Uses the formula in the SX1276 datasheet (section 4.1.1.7) with the
+ * settings RH_RF95 uses: an explicit header, a payload CRC, coding rate
+ * 4/5 and an 8 symbol preamble. Low data rate optimization is assumed
+ * when a symbol lasts more than 16 ms. RH_RF95 adds a 4 byte header of
+ * its own to every message, which is counted too.
+ *
+ * Airtime rather than bytes is what a duty cycle limit, a battery and
+ * the other nodes on the channel care about. Every frame pays for its
+ * preamble, 12.5 ms at SF7 and 125 kHz and 400 ms at SF12, so a few
+ * bytes saved per frame can matter less than sending fewer frames.
+ */
+
+#ifndef h_airtime_h
+#define h_airtime_h
+
+#include <Arduino.h>
+
+/// RH_RF95's default modem config is 125 kHz, 4/5, SF7
+#define LORA_DEFAULT_SF 7
+#define LORA_DEFAULT_BANDWIDTH 125000
+
+/// Preamble length RH_RF95 sends, in symbols
+#define LORA_PREAMBLE_SYMBOLS 8
+
+/// The header RH_RF95 sends before each message: to, from, id and flags
+#define LORA_RH_HEADER_SIZE 4
+
+uint32_t lora_airtime_us(uint8_t len, uint8_t spreading_factor = LORA_DEFAULT_SF,
+                         uint32_t bandwidth = LORA_DEFAULT_BANDWIDTH);
+
+#endif
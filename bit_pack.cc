@@ -0,0 +1,80 @@
+// Bit-packed field encode and decode functions.
+
+#include <Arduino.h>
+
+#include "bit_pack.h"
+
+/**
+ * @brief Start writing at the beginning of buf
+ * @param w The writer
+ * @param buf Destination; bytes are filled as bits are written
+ */
+void init_bit_writer(bit_writer_t *w, uint8_t *buf) {
+    w->buf = buf;
+    w->bit = 0;
+}
+
+/**
+ * @brief Write the low bits of a value
+ * @param w The writer
+ * @param value The value; bits above 'bits' are ignored
+ * @param bits The width, 1 to 32
+ */
+void put_bits(bit_writer_t *w, uint32_t value, uint8_t bits) {
+    while (bits > 0) {
+        uint8_t shift = w->bit & 7;
+        uint8_t n = 8 - shift;
+        if (n > bits)
+            n = bits;
+
+        uint8_t *p = w->buf + (w->bit >> 3);
+        if (shift == 0)
+            *p = 0;
+        *p |= (uint8_t)((value & ((1u << n) - 1)) << shift);
+
+        value >>= n;
+        bits -= n;
+        w->bit += n;
+    }
+}
+
+/**
+ * @brief Start reading at the beginning of buf
+ * @param r The reader
+ * @param buf Source bytes
+ * @param len The number of bytes available in buf
+ */
+void init_bit_reader(bit_reader_t *r, const uint8_t *buf, uint8_t len) {
+    r->buf = buf;
+    r->bit = 0;
+    r->end = (uint16_t)len * 8;
+}
+
+/**
+ * @brief Read a value
+ * @param r The reader
+ * @param bits The width, 1 to 32
+ * @param value V-R parameter for the value
+ * @return true if the bits were read, false if there are not enough left
+ */
+bool get_bits(bit_reader_t *r, uint8_t bits, uint32_t *value) {
+    if (r->bit + bits > r->end)
+        return false;
+
+    uint32_t v = 0;
+    uint8_t done = 0;
+    while (done < bits) {
+        uint8_t shift = r->bit & 7;
+        uint8_t n = 8 - shift;
+        if (n > bits - done)
+            n = bits - done;
+
+        v |= (uint32_t)((r->buf[r->bit >> 3] >> shift) & ((1u << n) - 1)) << done;
+
+        done += n;
+        r->bit += n;
+    }
+
+    *value = v;
+    return true;
+}
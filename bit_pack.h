@@ -0,0 +1,32 @@
+/**
+ * Read and write values of any width from 1 to 32 bits packed one after
+ * another into a byte buffer. Bits are filled least significant first,
+ * the same order as the rest of the wire format.
+ */
+
+#ifndef h_bit_pack_h
+#define h_bit_pack_h
+
+#include <Arduino.h>
+
+struct bit_writer_t {
+    uint8_t *buf;
+    uint16_t bit;       // next bit to write
+};
+
+struct bit_reader_t {
+    const uint8_t *buf;
+    uint16_t bit;       // next bit to read
+    uint16_t end;       // bits available
+};
+
+/// Bytes needed to hold 'bits' bits
+#define BIT_PACK_BYTES(bits) (((bits) + 7) / 8)
+
+void init_bit_writer(bit_writer_t *w, uint8_t *buf);
+void put_bits(bit_writer_t *w, uint32_t value, uint8_t bits);
+
+void init_bit_reader(bit_reader_t *r, const uint8_t *buf, uint8_t len);
+bool get_bits(bit_reader_t *r, uint8_t bits, uint32_t *value);
+
+#endif
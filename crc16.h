@@ -0,0 +1,15 @@
+/**
+ * CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xffff, no
+ * reflection and no final xor.
+ */
+
+#ifndef h_crc16_h
+#define h_crc16_h
+
+#include <Arduino.h>
+
+#define CRC16_INIT 0xffff
+
+uint16_t crc16(const uint8_t *buf, size_t len, uint16_t crc = CRC16_INIT);
+
+#endif
@@ -0,0 +1,118 @@
+// functions to build, parse and print batches of data packets.
+
+#include <Arduino.h>
+
+#include "data_batch.h"
+
+/**
+ * @brief Start an empty batch
+ * @param batch Pointer to the batch
+ * @param node The node number of the leaf sending the batch
+ */
+void build_data_batch(data_batch_t *batch, const uint8_t node) {
+    batch->type = data_batch;
+    batch->node = node;
+    batch->count = 0;
+    batch->message = 0;
+    batch->time = 0;
+}
+
+/**
+ * @brief Add a data packet to a batch
+ *
+ * The first packet sets the batch's message number and base time. Each
+ * following packet must have the next message number and a time no
+ * more than 65535 seconds after the first.
+ *
+ * @param batch The batch
+ * @param data The packet to add
+ * @return true if the packet was added, false if the batch is full or
+ * the packet cannot be part of it. In that case, send the batch and
+ * start a new one with this packet.
+ */
+bool add_data_batch_reading(data_batch_t *batch, const packet_t *data) {
+    if (batch->count >= DATA_BATCH_MAX_READINGS || data->node != batch->node)
+        return false;
+
+    if (batch->count == 0) {
+        batch->message = data->message;
+        batch->time = data->time;
+    }
+    else if (data->message != batch->message + batch->count
+             || data->time < batch->time || data->time - batch->time > 0xffff) {
+        return false;
+    }
+
+    batch_reading_t *r = &batch->readings[batch->count++];
+    r->time_offset = (uint16_t)(data->time - batch->time);
+    r->battery = data->battery;
+    r->last_tx_duration = data->last_tx_duration;
+    r->temp = data->temp;
+    r->humidity = data->humidity;
+    r->status = data->status;
+    r->data = data->data;
+
+    return true;
+}
+
+/**
+ * @brief extract the header information from a data_batch message
+ * @param batch The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the node number of the sender
+ * @param count If not null, returns the number of readings in the batch
+ * @return true if this is a data_batch message, false otherwise.
+ */
+bool parse_data_batch(const data_batch_t *batch, uint8_t len, uint8_t *node, uint8_t *count) {
+    if (len < DATA_BATCH_HEADER_SIZE || get_message_type(batch) != data_batch
+        || batch->count > DATA_BATCH_MAX_READINGS || !check_message_frame(batch, len, DATA_BATCH_SIZE(batch)))
+        return false;
+
+    if (node)
+        *node = batch->node;
+    if (count)
+        *count = batch->count;
+
+    return true;
+}
+
+/**
+ * @brief Get one reading from a batch as a data packet
+ * @param batch The batch
+ * @param index The reading, 0 to count - 1
+ * @param data V-R parameter for the reading
+ * @return true if the reading exists, false otherwise.
+ */
+bool get_data_batch_reading(const data_batch_t *batch, const uint8_t index, packet_t *data) {
+    if (get_message_type(batch) != data_batch || index >= batch->count || index >= DATA_BATCH_MAX_READINGS)
+        return false;
+
+    const batch_reading_t *r = &batch->readings[index];
+    build_data_packet(data, batch->node, batch->message + index, batch->time + r->time_offset,
+                      r->battery, r->last_tx_duration, r->temp, r->humidity, r->status);
+    data->data = r->data;
+
+    return true;
+}
+
+/**
+ * @brief Write a string representation for the header of a data batch
+ * @param batch The batch
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t data_batch_to_string(const data_batch_t *batch, char *buf, size_t len, bool pretty /* false */) {
+    int n;
+    if (pretty) {
+        n = snprintf(buf, len, "node: %u, message: %lu, time: %lu, readings: %u",
+                     batch->node, (unsigned long)batch->message, (unsigned long)batch->time, batch->count);
+    }
+    else {
+        n = snprintf(buf, len, "%u, %lu, %lu, %u",
+                     batch->node, (unsigned long)batch->message, (unsigned long)batch->time, batch->count);
+    }
+
+    return written_length(n, len);
+}
@@ -0,0 +1,60 @@
+/**
+ * Several data packets from one leaf node sent in a single frame. The
+ * node, first message number and base time are sent once; each reading
+ * carries its time as an offset in seconds from the base time. Readings
+ * have consecutive message numbers.
+ */
+
+#ifndef h_data_batch_h
+#define h_data_batch_h
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+
+#include "wire_format.h"
+#include "messages.h"
+#include "data_packet.h"
+
+/**
+ * One reading in a batch; a packet_t without the node, message number
+ * and absolute time.
+ */
+struct batch_reading_t {
+    uint16_t time_offset;   // seconds after data_batch_t::time
+    uint16_t battery;
+    uint16_t last_tx_duration;
+    int16_t temp;
+    uint16_t humidity;
+    uint8_t status;
+    uint8_t data;
+} PACKED;
+
+/// Size of the data batch header in bytes
+#define DATA_BATCH_HEADER_SIZE (sizeof(data_batch_t) - sizeof(data_batch_t::readings))
+
+/// The most readings that fit in one radio frame
+#define DATA_BATCH_MAX_READINGS 20
+
+struct data_batch_t {
+    MessageType type;   // data_batch
+    uint8_t node;
+    uint8_t count;      // Number of readings
+    uint32_t message;   // Message number of readings[0]
+    uint32_t time;      // Time of readings[0]
+    batch_reading_t readings[DATA_BATCH_MAX_READINGS];
+} PACKED;
+
+static_assert(sizeof(batch_reading_t) == 12, "batch_reading_t wire layout changed");
+static_assert(DATA_BATCH_HEADER_SIZE == 11, "data_batch_t wire layout changed");
+static_assert(sizeof(data_batch_t) <= RH_RF95_MAX_MESSAGE_LEN, "data_batch_t does not fit in one radio frame");
+
+/// The number of bytes to send for a batch
+#define DATA_BATCH_SIZE(b) (DATA_BATCH_HEADER_SIZE + (b)->count * sizeof(batch_reading_t))
+
+void build_data_batch(data_batch_t *batch, const uint8_t node);
+bool add_data_batch_reading(data_batch_t *batch, const packet_t *data);
+bool parse_data_batch(const data_batch_t *batch, uint8_t len, uint8_t *node, uint8_t *count);
+bool get_data_batch_reading(const data_batch_t *batch, const uint8_t index, packet_t *data);
+size_t data_batch_to_string(const data_batch_t *batch, char *buf, size_t len, bool pretty = false);
+
+#endif
@@ -0,0 +1,141 @@
+// functions to write and read the binary data log.
+
+#include <Arduino.h>
+
+#include "data_log.h"
+#include "crc16.h"
+
+/**
+ * @brief Build the header block for a new log file
+ * @param header The header block
+ */
+void build_data_log_header(data_log_header_t *header) {
+    memset(header, 0, sizeof(data_log_header_t));
+    header->magic = DATA_LOG_MAGIC;
+    header->version = DATA_LOG_VERSION;
+    header->schema = DATA_LOG_SCHEMA_PACKET;
+    header->record_size = DATA_PACKET_SIZE;
+    header->block_size = DATA_LOG_BLOCK_SIZE;
+    header->records_per_block = DATA_LOG_RECORDS_PER_BLOCK;
+    header->crc = crc16((const uint8_t *)header, offsetof(data_log_header_t, crc));
+}
+
+/**
+ * @brief Check a log file header
+ * @param header The first block of the file
+ * @return true if the file was written in the format this code reads,
+ * false otherwise.
+ */
+bool parse_data_log_header(const data_log_header_t *header) {
+    return header->magic == DATA_LOG_MAGIC
+           && header->crc == crc16((const uint8_t *)header, offsetof(data_log_header_t, crc))
+           && header->version == DATA_LOG_VERSION
+           && header->schema == DATA_LOG_SCHEMA_PACKET
+           && header->record_size == DATA_PACKET_SIZE
+           && header->block_size == DATA_LOG_BLOCK_SIZE
+           && header->records_per_block == DATA_LOG_RECORDS_PER_BLOCK;
+}
+
+/**
+ * @brief Start an empty block
+ * @param block The block
+ * @param sequence The block number; used to spot missing blocks
+ */
+void init_data_log_block(data_log_block_t *block, uint16_t sequence) {
+    memset(block, 0, sizeof(data_log_block_t));
+    block->sync = DATA_LOG_SYNC;
+    block->sequence = sequence;
+}
+
+/**
+ * @brief Add a record to a block
+ * @param block The block
+ * @param data The data packet to log
+ * @return true if the record was added, false if the block is full.
+ */
+bool add_data_log_record(data_log_block_t *block, const packet_t *data) {
+    if (block->count >= DATA_LOG_RECORDS_PER_BLOCK)
+        return false;
+
+    block->records[block->count++] = *data;
+    return true;
+}
+
+/**
+ * @brief Seal a block before it is written
+ * May be called on a partly full block, e.g., before the node sleeps.
+ * @param block The block
+ */
+void finish_data_log_block(data_log_block_t *block) {
+    block->crc = crc16((const uint8_t *)block, offsetof(data_log_block_t, crc));
+}
+
+/**
+ * @brief Check a block read from a log file
+ * @param block The block
+ * @param sequence If not null, returns the block number
+ * @param count If not null, returns the number of records
+ * @return true if the block is intact, false otherwise.
+ */
+bool parse_data_log_block(const data_log_block_t *block, uint16_t *sequence, uint8_t *count) {
+    if (block->sync != DATA_LOG_SYNC || block->count > DATA_LOG_RECORDS_PER_BLOCK
+        || block->crc != crc16((const uint8_t *)block, offsetof(data_log_block_t, crc)))
+        return false;
+
+    if (sequence)
+        *sequence = block->sequence;
+    if (count)
+        *count = block->count;
+
+    return true;
+}
+
+/**
+ * @brief Find the next intact block
+ *
+ * Use this to recover when a file has been truncated or a block
+ * is damaged and the following blocks are no longer aligned.
+ *
+ * @param buf Bytes read from the log file
+ * @param len The number of bytes in buf
+ * @return The offset in buf of the first intact block or -1 if there
+ * is none.
+ */
+int find_data_log_block(const uint8_t *buf, size_t len) {
+    const uint8_t sync_lo = DATA_LOG_SYNC & 0xff;
+    const uint8_t sync_hi = DATA_LOG_SYNC >> 8;
+
+    for (size_t i = 0; i + DATA_LOG_BLOCK_SIZE <= len; ++i) {
+        if (buf[i] == sync_lo && buf[i + 1] == sync_hi
+            && parse_data_log_block((const data_log_block_t *)(buf + i), 0, 0))
+            return (int)i;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Convert the records in a block to CSV lines
+ *
+ * Each line is the same as the one made by the non-pretty
+ * data_packet_to_string() and has no line terminator.
+ *
+ * @param block The block
+ * @param line Called with each line
+ * @param context Passed to line
+ * @return The number of records converted; 0 if the block is damaged.
+ */
+uint8_t data_log_block_to_csv(const data_log_block_t *block,
+                              void (*line)(const char *csv, size_t len, void *context), void *context) {
+    uint8_t count;
+    if (!parse_data_log_block(block, 0, &count))
+        return 0;
+
+    char csv[DATA_PACKET_CSV_LEN];
+    for (uint8_t i = 0; i < count; ++i) {
+        size_t n = data_packet_to_csv(&block->records[i], csv, sizeof(csv));
+        line(csv, n, context);
+    }
+
+    return count;
+}
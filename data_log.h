@@ -0,0 +1,66 @@
+/**
+ * An append-only binary log of data packets for the main node's SD card.
+ *
+ * The file is a sequence of DATA_LOG_BLOCK_SIZE byte blocks, so every
+ * block starts on an SD sector. The first block is a data_log_header_t
+ * that records the format version and the record layout. Every block
+ * after that is a data_log_block_t: a sync marker, a sequence number, a
+ * count and up to DATA_LOG_RECORDS_PER_BLOCK packed packet_t records,
+ * followed by a CRC-16 of the rest of the block. A reader that finds a
+ * damaged block skips to the next sync marker.
+ */
+
+#ifndef h_data_log_h
+#define h_data_log_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "data_packet.h"
+
+#define DATA_LOG_BLOCK_SIZE 512
+
+#define DATA_LOG_MAGIC 0x474c4d53   // "SMLG"
+#define DATA_LOG_VERSION 1
+#define DATA_LOG_SCHEMA_PACKET 1    // records are packet_t, see data_packet.h
+#define DATA_LOG_SYNC 0xa55a
+
+#define DATA_LOG_RECORDS_PER_BLOCK ((DATA_LOG_BLOCK_SIZE - 8) / DATA_PACKET_SIZE)
+
+struct data_log_header_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t schema;
+    uint16_t record_size;
+    uint16_t block_size;
+    uint16_t records_per_block;
+    uint8_t reserved[DATA_LOG_BLOCK_SIZE - 14];
+    uint16_t crc;
+} PACKED;
+
+struct data_log_block_t {
+    uint16_t sync;
+    uint16_t sequence;
+    uint8_t count;
+    uint8_t reserved;
+    packet_t records[DATA_LOG_RECORDS_PER_BLOCK];
+    uint8_t pad[DATA_LOG_BLOCK_SIZE - 8 - DATA_LOG_RECORDS_PER_BLOCK * DATA_PACKET_SIZE];
+    uint16_t crc;
+} PACKED;
+
+static_assert(sizeof(data_log_header_t) == DATA_LOG_BLOCK_SIZE, "data_log_header_t must fill one block");
+static_assert(sizeof(data_log_block_t) == DATA_LOG_BLOCK_SIZE, "data_log_block_t must fill one block");
+
+void build_data_log_header(data_log_header_t *header);
+bool parse_data_log_header(const data_log_header_t *header);
+
+void init_data_log_block(data_log_block_t *block, uint16_t sequence);
+bool add_data_log_record(data_log_block_t *block, const packet_t *data);
+void finish_data_log_block(data_log_block_t *block);
+bool parse_data_log_block(const data_log_block_t *block, uint16_t *sequence, uint8_t *count);
+
+int find_data_log_block(const uint8_t *buf, size_t len);
+uint8_t data_log_block_to_csv(const data_log_block_t *block,
+                              void (*line)(const char *csv, size_t len, void *context), void *context);
+
+#endif
@@ -5,10 +5,11 @@
 #include <assert.h>
 
 #include "data_packet.h"
+#include "message_schema.h"
 
 /**
  * @brief Encode information for transmission
- * Information is stored in the data buffer. The data packets uses 12 bytes.
+ * Information is stored in the data buffer. The data packet uses DATA_PACKET_SIZE (20) bytes.
  * @param data Pointer to a buffer
  * @param node Unsigned Byte the holds the node number
  * @param message Unsigned Long that holds the message number
@@ -18,25 +19,20 @@
  * @param temp Short with temperature in degrees C * 100
  * @param humidity Unsigend Short with percent relative humidity * 100
  * @param status Unsigned Byte with the leaf node status.
- * @return The number of bytes in the packet.
+ * Every byte of the packet is set; the spare \c data byte is zero.
  */
 void build_data_packet(packet_t *data, const uint8_t node, const uint32_t message,
                        const uint32_t time, const uint16_t battery, const uint16_t last_tx_duration,
                        const int16_t temp, const uint16_t humidity, const uint8_t status) {
 
-    data->node = node;
-    data->message = message;
-    data->time = time;
-    data->battery = battery;
-    data->last_tx_duration = last_tx_duration;
-    data->temp = temp;
-    data->humidity = humidity;
-    data->status = status;
+    data_packet_schema::ops::encode((uint8_t *)data, data_packet, message, time, battery, last_tx_duration, temp,
+                                    humidity, status, 0, node);
 }
 
 /**
  * @brief Unpack a data packet
  * @param data Pointer to a DATA_PACKET_SIZE byte data packet
+ * @param len The number of bytes received, including any CRC trailer
  * @param node Value-result parameter for the node number. if NULL, no value is extracted
  * @param message if not NULL, V-R parameter for the message number
  * @param time If not NULL, V-R parameter for epoch time. 
@@ -45,69 +41,66 @@ void build_data_packet(packet_t *data, const uint8_t node, const uint32_t messag
  * @param temp If not NULL, V-R parameter for temperature om C * 100
  * @param humidity If not NULL, V-R parameter for percent rel. humidity * 100
  * @param status If not NULL, V-R parameter for status info
+ * @return true if this is a data_packet message, false otherwise.
  */
-void parse_data_packet(const packet_t *data, uint8_t *node, uint32_t *message, uint32_t *time,
-                       uint16_t *battery, uint16_t *last_tx_duration, int16_t *temp, uint16_t *humidity, uint8_t *status) {
-    if (node)
-        *node = data->node;
-
-    if (message)
-        *message = data->message;
-
-    if (time)
-        *time = data->time;
-
-    if (battery)
-        *battery = data->battery;
-
-    if (last_tx_duration)
-        *last_tx_duration = data->last_tx_duration;
-
-    if (temp)
-        *temp = data->temp;
-
-    if (humidity)
-        *humidity = data->humidity;
-
-    if (status)
-        *status = data->status;
+bool parse_data_packet(const packet_t *data, uint8_t len, uint8_t *node, uint32_t *message, uint32_t *time,
+                       uint16_t *battery, uint16_t *last_tx_duration, int16_t *temp, uint16_t *humidity,
+                       uint8_t *status) {
+    if (!check_message_frame(data, len, DATA_PACKET_SIZE) || get_message_type(data) != data_packet)
+        return false;
+
+    data_packet_schema::ops::decode((const uint8_t *)data, 0, message, time, battery, last_tx_duration, temp,
+                                    humidity, status, 0, node);
+    return true;
 }
 
 /**
- * @brief print the data packet to a string
- * 
- * Print the data in packet to a string. The returned pointer is to
- * static storage and will be changed by subsequent calls to this funtion.
- * If the optional parameter \c pretty is true, add info for a human.
- * 
+ * @brief print the data packet to a caller's buffer
+ *
+ * This version is reentrant. If the optional parameter \c pretty is
+ * true, add info for a human. A buffer of DATA_PACKET_STRING_LEN
+ * characters holds either version.
+ *
  * @param data The data packet
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
  * @param pretty Optional, if true, print names, units, etc. Default: false
- * @return Pointer to the string in static storage. Always null terminated.
+ * @return The number of characters written, not counting the null.
  */
-char *data_packet_to_string(const packet_t *data, bool pretty /* false */) {
-    uint8_t node;
-    uint32_t time;
-    uint32_t message;
-    uint16_t battery;
-    uint16_t last_tx_duration;
-    int16_t temp;
-    uint16_t humidity;
-    uint8_t status;
-
-    parse_data_packet(data, &node, &message, &time, &battery, &last_tx_duration, &temp, &humidity, &status);
-
-    static char decoded_string[256];
+size_t data_packet_to_string(const packet_t *data, char *buf, size_t len, bool pretty /* false */) {
+    int n;
     if (pretty) {
         // string length 62 characters + 2 bytes (6 chars) + 2 Longs (20) + 3 Shorts (15)
         // = 62 + 41 = 103
-        snprintf((char *)decoded_string, sizeof(decoded_string),
-                 "node: %u, message: %lu, time: %lu, Vbat %u v, Tx dur %u ms, T: %d C, RH: %u %%, status: 0x%02x",
-                 node, message, time, battery, last_tx_duration, temp, humidity, (unsigned int)status);
+        n = snprintf(buf, len,
+                     "node: %u, message: %lu, time: %lu, Vbat %u v, Tx dur %u ms, T: %d C, RH: %u %%, status: 0x%02x",
+                     data->node, (unsigned long)data->message, (unsigned long)data->time, data->battery,
+                     data->last_tx_duration, data->temp, data->humidity, (unsigned int)data->status);
     } else {
-        snprintf((char *)decoded_string, sizeof(decoded_string),
-                 "%u, %lu, %lu, %u, %u, %d, %u, 0x%02x",
-                 node, message, time, battery, last_tx_duration, temp, humidity, (unsigned int)status);
+        return data_packet_to_csv(data, buf, len);
     }
 
-    return decoded_string;
+    return written_length(n, len);
+}
+
+/**
+ * @brief print the data packet as a CSV line without using snprintf()
+ *
+ * With \c scaled false the line is the same as the one made by the
+ * non-pretty data_packet_to_string(). With \c scaled true, battery,
+ * temp and humidity are printed as their real values, e.g., '3.71'
+ * and '-4.25', instead of the value * 100.
+ *
+ * @param data The data packet
+ * @param buf Destination for the line, always null terminated
+ * @param len The size of buf. DATA_PACKET_CSV_LEN is always enough.
+ * @param scaled Optional, if true, print the * 100 values with two
+ * decimal places. Default: false
+ * @return The number of characters written, not counting the null.
+ */
+size_t data_packet_to_csv(const packet_t *data, char *buf, size_t len, bool scaled /* false */) {
+    if (scaled)
+        return format_fields<data_packet_schema::scaled_csv>(data, buf, len);
+
+    return format_fields<data_packet_schema::csv>(data, buf, len);
 }
@@ -5,10 +5,14 @@
 
 #include <Arduino.h>
 
+#include "wire_format.h"
+#include "messages.h"
+
 /// Size of the data packet in bytes
 #define DATA_PACKET_SIZE sizeof(packet_t)
 
 struct packet_t {
+    MessageType type;   // data_packet
     uint32_t message;
     uint32_t time;
     uint16_t battery;
@@ -18,15 +22,25 @@ struct packet_t {
     uint8_t status;
     uint8_t data;
     uint8_t node;
-};
+} PACKED;
+
+static_assert(DATA_PACKET_SIZE == 20, "packet_t wire layout changed");
 
 void build_data_packet(packet_t *data, const uint8_t node, const uint32_t message, const uint32_t time,
                        const uint16_t battery, const uint16_t last_tx_duration,
                        const int16_t temp, const uint16_t humidity, const uint8_t status);
 
-void parse_data_packet(const packet_t *data, uint8_t *node, uint32_t *message, uint32_t *time, uint16_t *battery,
-                       uint16_t *last_tx_duration, int16_t *temp, uint16_t *humidity, uint8_t *status);
+bool parse_data_packet(const packet_t *data, uint8_t len, uint8_t *node, uint32_t *message, uint32_t *time,
+                       uint16_t *battery, uint16_t *last_tx_duration, int16_t *temp, uint16_t *humidity,
+                       uint8_t *status);
+
+/// Buffer size that holds any string made by data_packet_to_string()
+#define DATA_PACKET_STRING_LEN 128
+
+/// Buffer size that holds any line made by data_packet_to_csv()
+#define DATA_PACKET_CSV_LEN 80
 
-char *data_packet_to_string(const packet_t *data, bool pretty = false);
+size_t data_packet_to_string(const packet_t *data, char *buf, size_t len, bool pretty = false);
+size_t data_packet_to_csv(const packet_t *data, char *buf, size_t len, bool scaled = false);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,187 @@
+// functions to aggregate samples and build, parse and print data summaries.
+
+#include <Arduino.h>
+
+#include "data_summary.h"
+
+/**
+ * @brief Start aggregating
+ * @param agg The aggregator
+ * @param node This leaf's node number
+ * @param interval Seconds between summaries, e.g., the reporting interval
+ * from leaf_config_t
+ */
+void init_data_aggregator(data_aggregator_t *agg, uint8_t node, uint16_t interval) {
+    memset(agg, 0, sizeof(data_aggregator_t));
+    agg->node = node;
+    agg->interval = interval;
+}
+
+/**
+ * @brief Send a summary at once when a value jumps
+ * @param agg The aggregator
+ * @param field The value to watch
+ * @param threshold The change from the mean, in the value's units, that
+ * triggers a summary; 0 == never
+ */
+void set_summary_threshold(data_aggregator_t *agg, SummaryField field, uint16_t threshold) {
+    agg->threshold[field] = threshold;
+}
+
+/// The mean of a field in the current window, rounded
+static int32_t window_mean(const data_aggregator_t *agg, uint8_t f) {
+    int32_t sum = agg->stats[f].sum;
+    int32_t half = agg->count / 2;
+    return (sum >= 0 ? sum + half : sum - half) / agg->count;
+}
+
+/**
+ * @brief Add a sample to the current window
+ * @param agg The aggregator
+ * @param sample The sample; the node and message number are not used
+ * @param moisture Soil moisture for the sample
+ * @return true if a summary should be sent now, because the interval is
+ * up, a value passed its threshold or the window is full; false otherwise.
+ * A sample added to a full window is dropped.
+ */
+bool add_summary_sample(data_aggregator_t *agg, const packet_t *sample, uint16_t moisture /* 0 */) {
+    if (agg->count == 255)
+        return true;
+
+    const int32_t values[SUMMARY_FIELDS] = {sample->battery, sample->temp, sample->humidity, moisture};
+
+    bool jump = false;
+    for (uint8_t f = 0; f < SUMMARY_FIELDS; ++f) {
+        if (agg->threshold[f] == 0 || (agg->count == 0 && !agg->have_last))
+            continue;
+        int32_t mean = agg->count > 0 ? window_mean(agg, f) : agg->last_mean[f];
+        int32_t change = values[f] - mean;
+        if (change > agg->threshold[f] || -change > agg->threshold[f])
+            jump = true;
+    }
+
+    if (agg->count == 0) {
+        agg->start = sample->time;
+        agg->status = 0;
+        for (uint8_t f = 0; f < SUMMARY_FIELDS; ++f)
+            agg->stats[f].sum = agg->stats[f].min = agg->stats[f].max = values[f];
+    }
+    else {
+        for (uint8_t f = 0; f < SUMMARY_FIELDS; ++f) {
+            summary_stats_t *s = &agg->stats[f];
+            s->sum += values[f];
+            if (values[f] < s->min)
+                s->min = values[f];
+            if (values[f] > s->max)
+                s->max = values[f];
+        }
+    }
+
+    agg->end = sample->time;
+    agg->status |= sample->status;
+    agg->count++;
+
+    return jump || agg->count == 255 || agg->end - agg->start >= agg->interval;
+}
+
+/**
+ * @brief Build a summary of the current window and start a new one
+ * @param summary The message
+ * @param agg The aggregator
+ * @param message The message number for the summary
+ * @return true if the summary was built, false if there are no samples
+ */
+bool build_data_summary(data_summary_t *summary, data_aggregator_t *agg, uint32_t message) {
+    if (agg->count == 0)
+        return false;
+
+    int32_t mean[SUMMARY_FIELDS];
+    for (uint8_t f = 0; f < SUMMARY_FIELDS; ++f)
+        mean[f] = agg->last_mean[f] = window_mean(agg, f);
+
+    const summary_stats_t *s = agg->stats;
+    summary->type = data_summary;
+    summary->node = agg->node;
+    summary->message = message;
+    summary->time = agg->start;
+    summary->duration = (agg->end - agg->start > 0xffff) ? 0xffff : (uint16_t)(agg->end - agg->start);
+    summary->count = agg->count;
+    summary->status = agg->status;
+    summary->battery_mean = (uint16_t)mean[summary_battery];
+    summary->battery_min = (uint16_t)s[summary_battery].min;
+    summary->battery_max = (uint16_t)s[summary_battery].max;
+    summary->temp_mean = (int16_t)mean[summary_temp];
+    summary->temp_min = (int16_t)s[summary_temp].min;
+    summary->temp_max = (int16_t)s[summary_temp].max;
+    summary->humidity_mean = (uint16_t)mean[summary_humidity];
+    summary->humidity_min = (uint16_t)s[summary_humidity].min;
+    summary->humidity_max = (uint16_t)s[summary_humidity].max;
+    summary->moisture_mean = (uint16_t)mean[summary_moisture];
+    summary->moisture_min = (uint16_t)s[summary_moisture].min;
+    summary->moisture_max = (uint16_t)s[summary_moisture].max;
+
+    agg->count = 0;
+    agg->have_last = true;
+
+    return true;
+}
+
+/**
+ * @brief extract the header information from a data_summary message
+ * @param summary The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the node number of the sender
+ * @param message If not null, returns the message number
+ * @param count If not null, returns the number of samples summarized
+ * @return true if this is a data_summary message, false otherwise.
+ */
+bool parse_data_summary(const data_summary_t *summary, uint8_t len, uint8_t *node, uint32_t *message,
+                        uint8_t *count) {
+    if (!check_message_frame(summary, len, DATA_SUMMARY_SIZE) || get_message_type(summary) != data_summary)
+        return false;
+
+    if (node)
+        *node = summary->node;
+    if (message)
+        *message = summary->message;
+    if (count)
+        *count = summary->count;
+
+    return true;
+}
+
+/**
+ * @brief Write a string representation for a data summary
+ *
+ * Each value is printed as mean, min and max.
+ *
+ * @param summary The message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t data_summary_to_string(const data_summary_t *summary, char *buf, size_t len, bool pretty /* false */) {
+    int n;
+    if (pretty) {
+        n = snprintf(buf, len, "node: %u, message: %lu, time: %lu, duration: %u s, samples: %u, status: %02x, "
+                     "battery: %u/%u/%u, temp: %d/%d/%d, humidity: %u/%u/%u, moisture: %u/%u/%u",
+                     summary->node, (unsigned long)summary->message, (unsigned long)summary->time,
+                     summary->duration, summary->count, summary->status,
+                     summary->battery_mean, summary->battery_min, summary->battery_max,
+                     summary->temp_mean, summary->temp_min, summary->temp_max,
+                     summary->humidity_mean, summary->humidity_min, summary->humidity_max,
+                     summary->moisture_mean, summary->moisture_min, summary->moisture_max);
+    }
+    else {
+        n = snprintf(buf, len, "%u, %lu, %lu, %u, %u, %02x, %u, %u, %u, %d, %d, %d, %u, %u, %u, %u, %u, %u",
+                     summary->node, (unsigned long)summary->message, (unsigned long)summary->time,
+                     summary->duration, summary->count, summary->status,
+                     summary->battery_mean, summary->battery_min, summary->battery_max,
+                     summary->temp_mean, summary->temp_min, summary->temp_max,
+                     summary->humidity_mean, summary->humidity_min, summary->humidity_max,
+                     summary->moisture_mean, summary->moisture_min, summary->moisture_max);
+    }
+
+    return written_length(n, len);
+}
@@ -0,0 +1,96 @@
+/**
+ * On-node aggregation of readings into summary messages.
+ *
+ * A leaf that samples more often than it needs to report adds each
+ * sample to a data_aggregator_t and sends a data_summary (mean, min and
+ * max of each value over the window, and the number of samples) once per
+ * reporting interval. If a value moves further than its threshold from
+ * the mean of the window so far, e.g., soil moisture when irrigation
+ * starts, the summary is sent right away so the main node hears of it
+ * quickly. All the math is integer and incremental; nothing but the
+ * running sums, minimums and maximums is kept.
+ */
+
+#ifndef h_data_summary_h
+#define h_data_summary_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "messages.h"
+#include "data_packet.h"
+
+/**
+ * The summarized values.
+ */
+enum SummaryField {
+    summary_battery = 0,    // V * 100
+    summary_temp = 1,       // C * 100
+    summary_humidity = 2,   // % * 100
+    summary_moisture = 3,   // VWC % * 100
+};
+
+#define SUMMARY_FIELDS 4
+
+/// Size of the data summary in bytes
+#define DATA_SUMMARY_SIZE sizeof(data_summary_t)
+
+struct data_summary_t {
+    MessageType type;       // data_summary
+    uint8_t node;
+    uint32_t message;
+    uint32_t time;          // time of the first sample
+    uint16_t duration;      // seconds from the first sample to the last
+    uint8_t count;          // number of samples
+    uint8_t status;         // status of every sample or'd together
+    uint16_t battery_mean;
+    uint16_t battery_min;
+    uint16_t battery_max;
+    int16_t temp_mean;
+    int16_t temp_min;
+    int16_t temp_max;
+    uint16_t humidity_mean;
+    uint16_t humidity_min;
+    uint16_t humidity_max;
+    uint16_t moisture_mean;
+    uint16_t moisture_min;
+    uint16_t moisture_max;
+} PACKED;
+
+static_assert(DATA_SUMMARY_SIZE == 38, "data_summary_t wire layout changed");
+
+/// Buffer size that holds any string made by data_summary_to_string()
+#define DATA_SUMMARY_STRING_LEN 224
+
+struct summary_stats_t {
+    int32_t sum;
+    int32_t min;
+    int32_t max;
+};
+
+/**
+ * Leaf node side state; the samples in the current window.
+ */
+struct data_aggregator_t {
+    summary_stats_t stats[SUMMARY_FIELDS];
+    int32_t last_mean[SUMMARY_FIELDS];      // from the last summary
+    uint16_t threshold[SUMMARY_FIELDS];     // 0 == no immediate send
+    uint32_t start;         // time of the first sample
+    uint32_t end;           // time of the last sample
+    uint16_t interval;      // seconds per summary
+    uint8_t count;
+    uint8_t status;
+    uint8_t node;
+    bool have_last;
+};
+
+void init_data_aggregator(data_aggregator_t *agg, uint8_t node, uint16_t interval);
+void set_summary_threshold(data_aggregator_t *agg, SummaryField field, uint16_t threshold);
+bool add_summary_sample(data_aggregator_t *agg, const packet_t *sample, uint16_t moisture = 0);
+
+bool build_data_summary(data_summary_t *summary, data_aggregator_t *agg, uint32_t message);
+bool parse_data_summary(const data_summary_t *summary, uint8_t len, uint8_t *node, uint32_t *message,
+                        uint8_t *count);
+size_t data_summary_to_string(const data_summary_t *summary, char *buf, size_t len, bool pretty = false);
+
+#endif
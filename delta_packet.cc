@@ -0,0 +1,251 @@
+// Functions to build and parse delta encoded data packets.
+
+#include <Arduino.h>
+
+#include "delta_packet.h"
+#include "varint.h"
+
+/**
+ * @brief Reset the leaf node's encoder
+ * The next packet built will be a keyframe.
+ * @param enc The encoder state
+ */
+void init_delta_encoder(delta_encoder_t *enc) {
+    memset(enc, 0, sizeof(delta_encoder_t));
+}
+
+/**
+ * @brief Encode a data packet as a data_delta frame
+ *
+ * The packet is encoded relative to the last packet passed to
+ * delta_packet_acked(). A keyframe is built if there is no such packet
+ * and otherwise once every DELTA_KEYFRAME_INTERVAL frames; since_keyframe
+ * counts the delta frames sent after the last keyframe.
+ *
+ * @param enc The encoder state
+ * @param buf Destination for the frame, at least DELTA_PACKET_MAX_SIZE bytes
+ * @param data The data packet to encode
+ * @return The number of bytes in the frame.
+ */
+uint8_t build_delta_packet(delta_encoder_t *enc, uint8_t *buf, const packet_t *data) {
+    const packet_t *ref = &enc->reference;
+    bool keyframe = !enc->valid || enc->since_keyframe >= DELTA_KEYFRAME_INTERVAL - 1;
+
+    buf[0] = data_delta;
+    buf[1] = data->node;
+    uint8_t flags = 0;
+    uint8_t n = 3;
+
+    if (keyframe) {
+        enc->since_keyframe = 0;
+        flags = DELTA_KEYFRAME;
+        n += put_varint(buf + n, data->message);
+        if (data->time) {
+            flags |= DELTA_TIME;
+            n += put_varint(buf + n, data->time);
+        }
+        if (data->battery) {
+            flags |= DELTA_BATTERY;
+            n += put_varint(buf + n, data->battery);
+        }
+        if (data->last_tx_duration) {
+            flags |= DELTA_LAST_TX_DURATION;
+            n += put_varint(buf + n, data->last_tx_duration);
+        }
+        if (data->temp) {
+            flags |= DELTA_TEMP;
+            n += put_varint(buf + n, zigzag_encode(data->temp));
+        }
+        if (data->humidity) {
+            flags |= DELTA_HUMIDITY;
+            n += put_varint(buf + n, data->humidity);
+        }
+        if (data->status) {
+            flags |= DELTA_STATUS;
+            buf[n++] = data->status;
+        }
+        if (data->data) {
+            flags |= DELTA_DATA;
+            buf[n++] = data->data;
+        }
+    }
+    else {
+        enc->since_keyframe++;
+        buf[n++] = (uint8_t)ref->message;
+        n += put_varint(buf + n, data->message - ref->message);
+        if (data->time != ref->time) {
+            flags |= DELTA_TIME;
+            n += put_varint(buf + n, zigzag_encode((int32_t)(data->time - ref->time)));
+        }
+        if (data->battery != ref->battery) {
+            flags |= DELTA_BATTERY;
+            n += put_varint(buf + n, zigzag_encode((int32_t)data->battery - ref->battery));
+        }
+        if (data->last_tx_duration != ref->last_tx_duration) {
+            flags |= DELTA_LAST_TX_DURATION;
+            n += put_varint(buf + n, zigzag_encode((int32_t)data->last_tx_duration - ref->last_tx_duration));
+        }
+        if (data->temp != ref->temp) {
+            flags |= DELTA_TEMP;
+            n += put_varint(buf + n, zigzag_encode((int32_t)data->temp - ref->temp));
+        }
+        if (data->humidity != ref->humidity) {
+            flags |= DELTA_HUMIDITY;
+            n += put_varint(buf + n, zigzag_encode((int32_t)data->humidity - ref->humidity));
+        }
+        if (data->status != ref->status) {
+            flags |= DELTA_STATUS;
+            buf[n++] = data->status;
+        }
+        if (data->data != ref->data) {
+            flags |= DELTA_DATA;
+            buf[n++] = data->data;
+        }
+    }
+
+    buf[2] = flags;
+    return n;
+}
+
+/**
+ * @brief Record that the main node acknowledged a packet
+ * Subsequent frames are encoded relative to this packet.
+ * @param enc The encoder state
+ * @param data The packet that was acknowledged
+ */
+void delta_packet_acked(delta_encoder_t *enc, const packet_t *data) {
+    enc->reference = *data;
+    enc->valid = true;
+}
+
+/**
+ * @brief Reset the main node's state for one leaf node
+ * @param dec The decoder state
+ */
+void init_delta_decoder(delta_decoder_t *dec) {
+    memset(dec, 0, sizeof(delta_decoder_t));
+}
+
+/**
+ * @brief Decode a data_delta frame
+ *
+ * On success the packet is added to the decoder's history so that it
+ * can be used as the reference for later frames from the same node.
+ *
+ * @param dec The decoder state for the node in byte 1 of the frame
+ * @param buf The frame
+ * @param len The number of bytes in the frame
+ * @param data V-R parameter for the decoded packet
+ * @return true if the frame was decoded, false if it is not a data_delta
+ * frame, is truncated or refers to a packet this node no longer has.
+ */
+bool parse_delta_packet(delta_decoder_t *dec, const uint8_t *buf, uint8_t len, packet_t *data) {
+    if (len < 4 || get_message_type(buf) != data_delta)
+        return false;
+
+    if (message_has_crc(buf)) {
+        if (len < 4 + MESSAGE_CRC_SIZE || !check_message_crc(buf, len - MESSAGE_CRC_SIZE))
+            return false;
+        len -= MESSAGE_CRC_SIZE;
+    }
+
+    uint8_t flags = buf[2];
+    uint8_t n = 3;
+    uint8_t used;
+    uint32_t v;
+    packet_t p;
+
+// Read one varint into 'v' or fail
+#define NEXT_VARINT() \
+    if (!(used = get_varint(buf + n, len - n, &v))) return false; \
+    n += used
+
+    if (flags & DELTA_KEYFRAME) {
+        memset(&p, 0, sizeof(packet_t));
+        NEXT_VARINT();
+        p.message = v;
+        if (flags & DELTA_TIME) {
+            NEXT_VARINT();
+            p.time = v;
+        }
+        if (flags & DELTA_BATTERY) {
+            NEXT_VARINT();
+            p.battery = (uint16_t)v;
+        }
+        if (flags & DELTA_LAST_TX_DURATION) {
+            NEXT_VARINT();
+            p.last_tx_duration = (uint16_t)v;
+        }
+        if (flags & DELTA_TEMP) {
+            NEXT_VARINT();
+            p.temp = (int16_t)zigzag_decode(v);
+        }
+        if (flags & DELTA_HUMIDITY) {
+            NEXT_VARINT();
+            p.humidity = (uint16_t)v;
+        }
+    }
+    else {
+        const packet_t *ref = 0;
+        for (uint8_t i = 0; i < dec->count; ++i) {
+            if ((uint8_t)dec->history[i].message == buf[3]) {
+                ref = &dec->history[i];
+                break;
+            }
+        }
+        if (!ref)
+            return false;
+
+        p = *ref;
+        n = 4;
+        NEXT_VARINT();
+        p.message = ref->message + v;
+        if (flags & DELTA_TIME) {
+            NEXT_VARINT();
+            p.time = ref->time + (uint32_t)zigzag_decode(v);
+        }
+        if (flags & DELTA_BATTERY) {
+            NEXT_VARINT();
+            p.battery = (uint16_t)(ref->battery + zigzag_decode(v));
+        }
+        if (flags & DELTA_LAST_TX_DURATION) {
+            NEXT_VARINT();
+            p.last_tx_duration = (uint16_t)(ref->last_tx_duration + zigzag_decode(v));
+        }
+        if (flags & DELTA_TEMP) {
+            NEXT_VARINT();
+            p.temp = (int16_t)(ref->temp + zigzag_decode(v));
+        }
+        if (flags & DELTA_HUMIDITY) {
+            NEXT_VARINT();
+            p.humidity = (uint16_t)(ref->humidity + zigzag_decode(v));
+        }
+    }
+
+#undef NEXT_VARINT
+
+    if (flags & DELTA_STATUS) {
+        if (n >= len)
+            return false;
+        p.status = buf[n++];
+    }
+    if (flags & DELTA_DATA) {
+        if (n >= len)
+            return false;
+        p.data = buf[n++];
+    }
+    p.type = data_packet;
+    p.node = buf[1];
+
+    // A retransmitted frame decodes to the packet already at the head
+    if (dec->count == 0 || dec->history[0].message != p.message) {
+        for (uint8_t i = DELTA_HISTORY - 1; i > 0; --i)
+            dec->history[i] = dec->history[i - 1];
+        dec->history[0] = p;
+        if (dec->count < DELTA_HISTORY)
+            dec->count++;
+    }
+
+    *data = p;
+    return true;
+}
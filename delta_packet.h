@@ -0,0 +1,75 @@
+/**
+ * A compact encoding for data packets. Most fields of a leaf node's
+ * packet_t change very little from one reading to the next, so instead
+ * of sending the full packet each time the leaf sends the difference
+ * from the last packet the main node acknowledged. Every
+ * DELTA_KEYFRAME_INTERVAL packets (or whenever there is no acknowledged
+ * packet to refer to) a keyframe with the full values is sent.
+ *
+ * Frame layout:
+ *  byte 0: data_delta
+ *  byte 1: node
+ *  byte 2: flags; DELTA_KEYFRAME plus one 'present' bit per field
+ *  keyframe: varint message, then each present field as a varint
+ *  delta:    low byte of the reference message number, varint message
+ *            increment, then each present field as a zig-zag varint delta
+ * status and data are always sent as single raw bytes. Fields that are
+ * not present are zero (keyframe) or unchanged (delta).
+ */
+
+#ifndef h_delta_packet_h
+#define h_delta_packet_h
+
+#include <Arduino.h>
+
+#include "messages.h"
+#include "data_packet.h"
+
+/// Send a full keyframe at least this often
+#define DELTA_KEYFRAME_INTERVAL 16
+
+/// Number of decoded packets the main node keeps for each leaf
+#define DELTA_HISTORY 2
+
+/// The largest encoded data_delta frame in bytes
+#define DELTA_PACKET_MAX_SIZE 28
+
+/** @name Delta frame flags */
+///@{
+#define DELTA_KEYFRAME 0x80
+#define DELTA_TIME 0x01
+#define DELTA_BATTERY 0x02
+#define DELTA_LAST_TX_DURATION 0x04
+#define DELTA_TEMP 0x08
+#define DELTA_HUMIDITY 0x10
+#define DELTA_STATUS 0x20
+#define DELTA_DATA 0x40
+///@}
+
+/**
+ * Leaf node side state; the last packet the main node acknowledged.
+ */
+struct delta_encoder_t {
+    packet_t reference;
+    uint8_t since_keyframe;
+    bool valid;
+};
+
+/**
+ * Main node side state for one leaf node; the most recently decoded
+ * packets, newest first. More than one is kept so that a lost ACK does
+ * not leave the two ends referring to different packets.
+ */
+struct delta_decoder_t {
+    packet_t history[DELTA_HISTORY];
+    uint8_t count;
+};
+
+void init_delta_encoder(delta_encoder_t *enc);
+uint8_t build_delta_packet(delta_encoder_t *enc, uint8_t *buf /* DELTA_PACKET_MAX_SIZE */, const packet_t *data);
+void delta_packet_acked(delta_encoder_t *enc, const packet_t *data);
+
+void init_delta_decoder(delta_decoder_t *dec);
+bool parse_delta_packet(delta_decoder_t *dec, const uint8_t *buf, uint8_t len, packet_t *data);
+
+#endif
@@ -0,0 +1,100 @@
+// Dispatch a received message to its handler.
+
+#include <Arduino.h>
+
+#include "dispatcher.h"
+
+// If the handler is set and the view is valid, call the handler
+#define DISPATCH(handler, view_type) { \
+        view_type view(buf, len); \
+        if (!handlers->handler || !view.valid()) \
+            return false; \
+        handlers->handler(view, context); \
+        return true; \
+    }
+
+/**
+ * @brief Call the handler for a received message
+ * @param handlers The handler table
+ * @param buf The message
+ * @param len The number of bytes in the message
+ * @param context Passed to the handler
+ * @return true if a handler was called, false if the message is empty,
+ * malformed, fails its CRC check, is of an unknown type or its type
+ * has no handler.
+ */
+bool dispatch_message(const message_handlers_t *handlers, const uint8_t *buf, uint8_t len, void *context) {
+    if (len == 0)
+        return false;
+
+    // The parse_*() functions for variable length messages check the
+    // trailer themselves, so their handlers get the whole frame
+    const uint8_t frame_len = len;
+    if (message_has_crc(buf)) {
+        if (len <= MESSAGE_CRC_SIZE || !check_message_crc(buf, len - MESSAGE_CRC_SIZE))
+            return false;
+        len -= MESSAGE_CRC_SIZE;
+    }
+
+    switch (get_message_type(buf)) {
+        case join_request:
+            DISPATCH(on_join_request, join_request_view);
+        case join_response:
+            DISPATCH(on_join_response, join_response_view);
+        case time_request:
+            DISPATCH(on_time_request, time_request_view);
+        case time_response:
+            DISPATCH(on_time_response, time_response_view);
+        case config:
+            DISPATCH(on_config, config_view);
+        case ack_bitmap:
+            DISPATCH(on_ack_bitmap, ack_bitmap_view);
+        case data_packet:
+            DISPATCH(on_data_packet, data_packet_view);
+        case text:
+            DISPATCH(on_text, text_view);
+        case data_batch:
+            DISPATCH(on_data_batch, data_batch_view);
+        case timing_report:
+            DISPATCH(on_timing_report, timing_report_view);
+        case data_summary:
+            DISPATCH(on_data_summary, data_summary_view);
+        case fragment_nack:
+            DISPATCH(on_fragment_nack, fragment_nack_view);
+
+        case data_delta:
+            if (!handlers->on_data_delta)
+                return false;
+            handlers->on_data_delta(buf, frame_len, context);
+            return true;
+
+        case stats:
+            if (!handlers->on_stats)
+                return false;
+            handlers->on_stats(buf, frame_len, context);
+            return true;
+
+        case data_packed:
+            if (!handlers->on_data_packed)
+                return false;
+            handlers->on_data_packed(buf, frame_len, context);
+            return true;
+
+        case data_sensors:
+            if (!handlers->on_data_sensors)
+                return false;
+            handlers->on_data_sensors(buf, frame_len, context);
+            return true;
+
+        case fragment:
+            if (!handlers->on_fragment)
+                return false;
+            handlers->on_fragment(buf, frame_len, context);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+#undef DISPATCH
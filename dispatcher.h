@@ -0,0 +1,57 @@
+/**
+ * Dispatch received messages to handlers by type.
+ *
+ * The type byte is read once and a switch on it selects the handler,
+ * which is passed a view of the message (see message_views.h). The
+ * handler table is normally a const, so it lives in flash:
+ *
+ * @code
+ * static const message_handlers_t handlers = {
+ *     on_join_request,    // on_join_request
+ *     0,                  // on_join_response, not expected on the main node
+ *     ...
+ * };
+ * ...
+ * if (rf95.recv(buf, &len))
+ *     dispatch_message(&handlers, buf, len, &state);
+ * @endcode
+ *
+ * A null entry means that message type is ignored. If the message has a
+ * CRC trailer it is checked first, and the handler sees the message
+ * without it. The exceptions are the variable length messages
+ * (on_data_delta, on_stats, on_data_packed, on_data_sensors,
+ * on_fragment), whose handlers are given the whole frame to pass to their
+ * parse_*() (or add_fragment()) function.
+ */
+
+#ifndef h_dispatcher_h
+#define h_dispatcher_h
+
+#include <Arduino.h>
+
+#include "messages.h"
+#include "message_views.h"
+
+struct message_handlers_t {
+    void (*on_join_request)(const join_request_view &msg, void *context);
+    void (*on_join_response)(const join_response_view &msg, void *context);
+    void (*on_time_request)(const time_request_view &msg, void *context);
+    void (*on_time_response)(const time_response_view &msg, void *context);
+    void (*on_data_packet)(const data_packet_view &msg, void *context);
+    void (*on_text)(const text_view &msg, void *context);
+    void (*on_data_delta)(const uint8_t *buf, uint8_t len, void *context);
+    void (*on_data_batch)(const data_batch_view &msg, void *context);
+    void (*on_timing_report)(const timing_report_view &msg, void *context);
+    void (*on_stats)(const uint8_t *buf, uint8_t len, void *context);
+    void (*on_config)(const config_view &msg, void *context);
+    void (*on_ack_bitmap)(const ack_bitmap_view &msg, void *context);
+    void (*on_data_packed)(const uint8_t *buf, uint8_t len, void *context);
+    void (*on_data_sensors)(const uint8_t *buf, uint8_t len, void *context);
+    void (*on_data_summary)(const data_summary_view &msg, void *context);
+    void (*on_fragment)(const uint8_t *buf, uint8_t len, void *context);
+    void (*on_fragment_nack)(const fragment_nack_view &msg, void *context);
+};
+
+bool dispatch_message(const message_handlers_t *handlers, const uint8_t *buf, uint8_t len, void *context);
+
+#endif
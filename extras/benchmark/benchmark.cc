@@ -0,0 +1,477 @@
+// Host benchmarks for the message encode, decode and format functions.
+//
+// Each case is run for about BENCH_MS milliseconds over a set of
+// realistic readings and reported as ns per call. The bytes column is
+// the size on the air (or on the card) of what the case produces.
+
+#include <Arduino.h>
+#include <chrono>
+
+#include "messages.h"
+#include "data_packet.h"
+#include "delta_packet.h"
+#include "data_batch.h"
+#include "message_views.h"
+#include "dispatcher.h"
+#include "fast_format.h"
+#include "crc16.h"
+#include "data_log.h"
+#include "sector_writer.h"
+#include "timing.h"
+#include "node_stats.h"
+#include "reading_cache.h"
+#include "gateway_merge.h"
+#include "ack_bitmap.h"
+#include "packed_packet.h"
+#include "sensor_packet.h"
+#include "data_summary.h"
+#include "fragment.h"
+
+#define BENCH_MS 100
+#define SAMPLES 64
+
+static volatile uint32_t sink;
+static packet_t samples[SAMPLES];
+
+/**
+ * Readings from one leaf every ten minutes: a slowly falling battery,
+ * a daily temperature swing and humidity that moves against it.
+ */
+static void make_samples() {
+    for (uint32_t i = 0; i < SAMPLES; ++i) {
+        int32_t swing = (int32_t)((i * 37) % 200) - 100;
+        build_data_packet(&samples[i], 17, 1000 + i, 1615680000 + 600 * i, (uint16_t)(395 - i / 16),
+                          (uint16_t)(140 + (i * 13) % 40), (int16_t)(1850 + 6 * swing),
+                          (uint16_t)(6200 - 9 * swing), i % 32 ? 0 : 0x01);
+        samples[i].data = 0;
+    }
+}
+
+template <typename F>
+static void bench(const char *name, size_t bytes, F f) {
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+    const clock::time_point stop = start + std::chrono::milliseconds(BENCH_MS);
+
+    uint64_t calls = 0;
+    clock::time_point now;
+    do {
+        for (uint32_t i = 0; i < 1024; ++i)
+            f((uint32_t)calls + i);
+        calls += 1024;
+        now = clock::now();
+    } while (now < stop);
+
+    double ns = std::chrono::duration<double, std::nano>(now - start).count() / calls;
+    if (bytes)
+        printf("%-40s %9.1f ns/op %6u bytes\n", name, ns, (unsigned)bytes);
+    else
+        printf("%-40s %9.1f ns/op\n", name, ns);
+}
+
+static bool sector_sink(const uint8_t *buf, size_t len, void *) {
+    sink += buf[0] + len;
+    return true;
+}
+
+static void on_data_packet(const data_packet_view &msg, void *) {
+    sink += msg.temp();
+}
+
+static void on_time_request(const time_request_view &msg, void *) {
+    sink += msg.node();
+}
+
+int main() {
+    make_samples();
+
+    printf("%-40s %12s %12s\n", "case", "time", "size");
+
+    /** data_packet.cc */
+    bench("build_data_packet", DATA_PACKET_SIZE, [](uint32_t i) {
+        packet_t p;
+        const packet_t &s = samples[i % SAMPLES];
+        build_data_packet(&p, s.node, s.message, s.time, s.battery, s.last_tx_duration, s.temp, s.humidity,
+                          s.status);
+        sink += p.temp;
+    });
+    bench("parse_data_packet", 0, [](uint32_t i) {
+        uint32_t time;
+        int16_t temp;
+        parse_data_packet(&samples[i % SAMPLES], DATA_PACKET_SIZE, 0, 0, &time, 0, 0, &temp, 0, 0);
+        sink += time + temp;
+    });
+    bench("data_packet_to_string", 0, [](uint32_t i) {
+        char buf[DATA_PACKET_STRING_LEN];
+        sink += data_packet_to_string(&samples[i % SAMPLES], buf, sizeof(buf));
+    });
+    bench("data_packet_to_string (pretty)", 0, [](uint32_t i) {
+        char buf[DATA_PACKET_STRING_LEN];
+        sink += data_packet_to_string(&samples[i % SAMPLES], buf, sizeof(buf), true);
+    });
+    bench("data_packet_to_csv (scaled)", 0, [](uint32_t i) {
+        char buf[DATA_PACKET_CSV_LEN];
+        sink += data_packet_to_csv(&samples[i % SAMPLES], buf, sizeof(buf), true);
+    });
+    bench("data_packet_view", 0, [](uint32_t i) {
+        data_packet_view v((const uint8_t *)&samples[i % SAMPLES], DATA_PACKET_SIZE);
+        sink += v.valid() ? v.time() + v.temp() : 0;
+    });
+
+    /** messages.cc */
+    bench("build_join_request", JOIN_REQUEST_SIZE, [](uint32_t i) {
+        join_request_t jr;
+        build_join_request(&jr, 0x0004a30b001a2b3cull + i);
+        sink += (uint32_t)jr.dev_eui;
+    });
+    bench("parse_join_request", 0, [](uint32_t i) {
+        join_request_t jr;
+        build_join_request(&jr, 0x0004a30b001a2b3cull + i);
+        uint64_t eui;
+        sink += parse_join_request(&jr, JOIN_REQUEST_SIZE, &eui) + (uint32_t)eui;
+    });
+    bench("join_request_to_string", 0, [](uint32_t i) {
+        join_request_t jr;
+        char buf[64];
+        build_join_request(&jr, 0x0004a30b001a2b3cull + i);
+        sink += join_request_to_string(&jr, buf, sizeof(buf));
+    });
+    bench("build_join_response", JOIN_RESPONSE_SIZE, [](uint32_t i) {
+        join_response_t jr;
+        build_join_response(&jr, (uint8_t)i, 1615680000 + i);
+        sink += jr.time;
+    });
+    bench("parse_join_response", 0, [](uint32_t i) {
+        join_response_t jr;
+        build_join_response(&jr, (uint8_t)i, 1615680000 + i);
+        uint32_t time;
+        sink += parse_join_response(&jr, JOIN_RESPONSE_SIZE, 0, &time) + time;
+    });
+    bench("join_response_to_string", 0, [](uint32_t i) {
+        join_response_t jr;
+        char buf[64];
+        build_join_response(&jr, (uint8_t)i, 1615680000 + i);
+        sink += join_response_to_string(&jr, buf, sizeof(buf));
+    });
+    bench("build_time_request", TIME_REQUEST_SIZE, [](uint32_t i) {
+        time_request_t tr;
+        build_time_request(&tr, (uint8_t)i);
+        sink += tr.node;
+    });
+    bench("parse_time_request", 0, [](uint32_t i) {
+        time_request_t tr;
+        build_time_request(&tr, (uint8_t)i);
+        uint8_t node;
+        sink += parse_time_request(&tr, TIME_REQUEST_SIZE, &node) + node;
+    });
+    bench("time_request_to_string", 0, [](uint32_t i) {
+        time_request_t tr;
+        char buf[64];
+        build_time_request(&tr, (uint8_t)i);
+        sink += time_request_to_string(&tr, buf, sizeof(buf));
+    });
+    bench("build_time_response", TIME_RESPONSE_SIZE, [](uint32_t i) {
+        time_response_t tr;
+        build_time_response(&tr, (uint8_t)i, 1615680000 + i);
+        sink += tr.time;
+    });
+    bench("parse_time_response", 0, [](uint32_t i) {
+        time_response_t tr;
+        build_time_response(&tr, (uint8_t)i, 1615680000 + i);
+        uint32_t time;
+        sink += parse_time_response(&tr, TIME_RESPONSE_SIZE, 0, &time) + time;
+    });
+    bench("time_response_to_string", 0, [](uint32_t i) {
+        time_response_t tr;
+        char buf[64];
+        build_time_response(&tr, (uint8_t)i, 1615680000 + i);
+        sink += time_response_to_string(&tr, buf, sizeof(buf));
+    });
+    bench("build_config", CONFIG_SIZE, [](uint32_t i) {
+        config_t c;
+        build_config(&c, (uint8_t)i, 600, 7 + i % 6, 13, 1 + i % 8);
+        sink += c.interval;
+    });
+    bench("parse_config", 0, [](uint32_t i) {
+        config_t c;
+        build_config(&c, (uint8_t)i, 600, 7 + i % 6, 13, 1 + i % 8);
+        uint16_t interval;
+        uint8_t sf;
+        sink += parse_config(&c, CONFIG_SIZE, 0, &interval, &sf, 0, 0) + interval + sf;
+    });
+    bench("config_to_string", 0, [](uint32_t i) {
+        config_t c;
+        char buf[64];
+        build_config(&c, (uint8_t)i, 600, 7 + i % 6, 13, 1 + i % 8);
+        sink += config_to_string(&c, buf, sizeof(buf));
+    });
+
+    static const char reading[] = "probe 1: 23.4% at 10 cm, probe 2: 31.0% at 30 cm";
+    const size_t text_len = sizeof(reading) - 1;
+    bench("build_text_message", offsetof(text_t, buf) + text_len, [&](uint32_t i) {
+        text_t t;
+        build_text_message(&t, (uint8_t)i, text_len, (const uint8_t *)reading);
+        sink += t.buf[i % text_len];
+    });
+    bench("parse_text_message", 0, [&](uint32_t i) {
+        static text_t t;
+        uint8_t buf[TEXT_BUF_LEN];
+        uint8_t length;
+        build_text_message(&t, (uint8_t)i, text_len, (const uint8_t *)reading);
+        sink += parse_text_message(&t, offsetof(text_t, buf) + text_len, 0, &length, buf) + buf[i % text_len];
+    });
+    bench("text_message_to_string", 0, [&](uint32_t i) {
+        static text_t t;
+        char buf[TEXT_BUF_LEN + 20];
+        build_text_message(&t, (uint8_t)i, text_len, (const uint8_t *)reading);
+        sink += text_message_to_string(&t, buf, sizeof(buf));
+    });
+
+    /** Compact encodings */
+    {
+        delta_encoder_t enc;
+        uint8_t buf[DELTA_PACKET_MAX_SIZE];
+        size_t total = 0;
+        init_delta_encoder(&enc);
+        for (uint32_t i = 0; i < SAMPLES; ++i) {
+            total += build_delta_packet(&enc, buf, &samples[i]);
+            delta_packet_acked(&enc, &samples[i]);
+        }
+
+        init_delta_encoder(&enc);
+        bench("build_delta_packet (mean size)", total / SAMPLES, [&](uint32_t i) {
+            const packet_t *p = &samples[i % SAMPLES];
+            sink += build_delta_packet(&enc, buf, p);
+            delta_packet_acked(&enc, p);
+        });
+
+        static uint8_t frames[SAMPLES][DELTA_PACKET_MAX_SIZE];
+        static uint8_t lens[SAMPLES];
+        init_delta_encoder(&enc);
+        for (uint32_t i = 0; i < SAMPLES; ++i) {
+            lens[i] = build_delta_packet(&enc, frames[i], &samples[i]);
+            delta_packet_acked(&enc, &samples[i]);
+        }
+        delta_decoder_t dec;
+        bench("parse_delta_packet", 0, [&](uint32_t i) {
+            if (i % SAMPLES == 0)
+                init_delta_decoder(&dec);
+            packet_t p;
+            sink += parse_delta_packet(&dec, frames[i % SAMPLES], lens[i % SAMPLES], &p) + p.temp;
+        });
+    }
+
+    {
+        static uint8_t frame[PACKED_PACKET_MAX_SIZE];
+        static uint8_t len = build_packed_packet(frame, &samples[0]);
+        bench("build_packed_packet", len, [](uint32_t i) {
+            sink += build_packed_packet(frame, &samples[i % SAMPLES]);
+        });
+        bench("parse_packed_packet", 0, [](uint32_t) {
+            packet_t p;
+            sink += parse_packed_packet(frame, len, &p) + p.temp;
+        });
+    }
+
+    {
+        static uint8_t frame[SENSOR_PACKET_MAX_SIZE];
+        static uint8_t len;
+        const size_t size = DATA_PACKET_SIZE + 4 * (SENSOR_READING_HEADER_SIZE + SENSOR_PROBE_VALUE_SIZE);
+        bench("build_sensor_packet (4 probes)", size, [](uint32_t i) {
+            len = build_sensor_packet(frame, &samples[i % SAMPLES]);
+            for (uint8_t d = 0; d < 4; ++d)
+                len = add_sensor_probe(frame, len, sensor_soil_moisture, 10 + 20 * d, (uint16_t)(2000 + d + i));
+            sink += len;
+        });
+        bench("parse_sensor_packet + readings", 0, [](uint32_t) {
+            uint8_t end, offset = DATA_PACKET_SIZE;
+            sensor_reading_t r;
+            uint16_t v;
+            if (parse_sensor_packet(frame, len, 0, &end))
+                while (next_sensor_reading(frame, end, &offset, &r))
+                    sink += get_sensor_probe(&r, 0, &v) + v;
+        });
+    }
+
+    {
+        static data_aggregator_t agg;
+        init_data_aggregator(&agg, 17, 3600);
+        bench("add_summary_sample", 0, [](uint32_t i) {
+            if (add_summary_sample(&agg, &samples[i % SAMPLES], (uint16_t)(2000 + i % 300))) {
+                data_summary_t summary;
+                sink += build_data_summary(&summary, &agg, i);
+            }
+        });
+        bench("build_data_summary (6 samples)", DATA_SUMMARY_SIZE, [](uint32_t i) {
+            data_summary_t summary;
+            for (uint8_t n = 0; n < 6; ++n)
+                add_summary_sample(&agg, &samples[(i + n) % SAMPLES]);
+            sink += build_data_summary(&summary, &agg, i) + summary.temp_mean;
+        });
+    }
+
+    {
+        static uint8_t data[FRAGMENT_MAX_TRANSFER];
+        static uint8_t out[FRAGMENT_MAX_TRANSFER];
+        static reassembly_t r;
+        for (size_t i = 0; i < sizeof(data); ++i)
+            data[i] = (uint8_t)(i * 31);
+        init_reassembly(&r, out, sizeof(out));
+        bench("fragment + reassemble (4 KB)", 4096 + get_fragment_count(4096) * FRAGMENT_HEADER_SIZE,
+              [](uint32_t i) {
+            uint8_t frame[RH_RF95_MAX_MESSAGE_LEN];
+            for (uint8_t f = 0; f < get_fragment_count(4096); ++f) {
+                uint8_t n = build_fragment(frame, 17, (uint8_t)i, data, 4096, f);
+                sink += add_fragment(&r, frame, n);
+            }
+        });
+        bench("build_fragment_nack", FRAGMENT_NACK_SIZE, [](uint32_t) {
+            fragment_nack_t nack;
+            build_fragment_nack(&nack, &r);
+            sink += nack.missing;
+        });
+        bench("parse_fragment_nack", 0, [](uint32_t i) {
+            fragment_nack_t nack;
+            build_fragment_nack(&nack, &r);
+            uint8_t id;
+            uint32_t missing;
+            sink += parse_fragment_nack(&nack, FRAGMENT_NACK_SIZE, 0, &id, &missing) + id + missing + i;
+        });
+        bench("fragment_nack_to_string", 0, [](uint32_t) {
+            fragment_nack_t nack;
+            char buf[64];
+            build_fragment_nack(&nack, &r);
+            sink += fragment_nack_to_string(&nack, buf, sizeof(buf));
+        });
+    }
+
+    {
+        static data_batch_t batch;
+        bench("add_data_batch_reading", 0, [](uint32_t i) {
+            if (i % DATA_BATCH_MAX_READINGS == 0)
+                build_data_batch(&batch, 17);
+            sink += add_data_batch_reading(&batch, &samples[i % DATA_BATCH_MAX_READINGS]);
+        });
+        build_data_batch(&batch, 17);
+        for (uint8_t r = 0; r < DATA_BATCH_MAX_READINGS; ++r)
+            add_data_batch_reading(&batch, &samples[r]);
+        printf("%-40s %12s %6u bytes (%u readings)\n", "data_batch, full", "",
+               (unsigned)DATA_BATCH_SIZE(&batch), batch.count);
+        bench("get_data_batch_reading", 0, [](uint32_t i) {
+            packet_t p;
+            sink += get_data_batch_reading(&batch, i % DATA_BATCH_MAX_READINGS, &p) + p.temp;
+        });
+    }
+
+    {
+        static timing_t timing;
+        init_timing(&timing);
+        bench("timing_start/timing_stop", 0, [](uint32_t) {
+            timing_stop(&timing, timing_encode, timing_start());
+        });
+        bench("build_timing_report", TIMING_REPORT_SIZE, [](uint32_t i) {
+            timing_report_t report;
+            build_timing_report(&report, (uint8_t)i, &timing);
+            sink += report.sections[timing_encode].mean;
+        });
+    }
+
+    {
+        static const node_stats_t stats = {1440, 37, 3, -108, -7, 3200, 2};
+        static uint8_t frame[STATS_MESSAGE_MAX_SIZE];
+        static uint8_t len = build_stats_message(frame, 17, &stats);
+        bench("build_stats_message", len, [](uint32_t i) {
+            sink += build_stats_message(frame, (uint8_t)i, &stats);
+        });
+        bench("parse_stats_message", 0, [](uint32_t) {
+            node_stats_t s;
+            sink += parse_stats_message(frame, len, 0, &s) + s.retries;
+        });
+    }
+
+    {
+        static ack_bitmap_t acks;
+        bench("build_ack_bitmap (60 nodes)", ACK_BITMAP_HEADER_SIZE + 60 * sizeof(ack_entry_t), [](uint32_t i) {
+            build_ack_bitmap(&acks, 0, 1615680000 + i);
+            for (uint8_t n = 1; n <= 60; ++n)
+                add_ack_bitmap_entry(&acks, n, i + n);
+            sink += acks.count;
+        });
+        bench("ack_bitmap_acks", 0, [](uint32_t i) {
+            sink += ack_bitmap_acks(&acks, (uint8_t)(i % 60 + 1), i);
+        });
+    }
+
+    /** Receive path */
+    {
+        // Static, so every handler starts out null
+        static message_handlers_t handlers;
+        handlers.on_time_request = on_time_request;
+        handlers.on_data_packet = on_data_packet;
+        static uint8_t frame[DATA_PACKET_SIZE + MESSAGE_CRC_SIZE];
+        bench("dispatch_message (data packet)", 0, [](uint32_t i) {
+            sink += dispatch_message(&handlers, (const uint8_t *)&samples[i % SAMPLES], DATA_PACKET_SIZE, 0);
+        });
+        memcpy(frame, &samples[0], DATA_PACKET_SIZE);
+        size_t len = add_message_crc(frame, DATA_PACKET_SIZE, sizeof(frame));
+        bench("dispatch_message (data packet + CRC)", len, [&](uint32_t) {
+            sink += dispatch_message(&handlers, frame, (uint8_t)len, 0);
+        });
+    }
+
+    {
+        static uint8_t frame[RH_RF95_MAX_MESSAGE_LEN];
+        for (size_t i = 0; i < sizeof(frame); ++i)
+            frame[i] = (uint8_t)(i * 31);
+        bench("crc16 (251 bytes)", 0, [](uint32_t) {
+            sink += crc16(frame, sizeof(frame));
+        });
+    }
+
+    /** Main node logging */
+    {
+        static data_log_block_t block;
+        bench("data log block (25 records)", DATA_LOG_BLOCK_SIZE, [](uint32_t i) {
+            init_data_log_block(&block, (uint16_t)i);
+            for (uint8_t r = 0; r < DATA_LOG_RECORDS_PER_BLOCK; ++r)
+                add_data_log_record(&block, &samples[r]);
+            finish_data_log_block(&block);
+            sink += block.crc;
+        });
+
+        static sector_writer_t writer;
+        init_sector_writer(&writer, sector_sink, 0);
+        bench("sector_writer_write (CSV line)", 0, [](uint32_t i) {
+            char buf[DATA_PACKET_CSV_LEN];
+            size_t n = data_packet_to_csv(&samples[i % SAMPLES], buf, sizeof(buf));
+            buf[n++] = '\n';
+            sink += sector_writer_write(&writer, buf, n);
+        });
+    }
+
+    {
+        static reading_cache_t cache;
+        init_reading_cache(&cache);
+        bench("add_cached_reading", 0, [](uint32_t i) {
+            sink += add_cached_reading(&cache, &samples[i % SAMPLES], (uint16_t)(2000 + i % 300));
+        });
+        bench("get_cached_summary", 0, [](uint32_t i) {
+            reading_summary_t s;
+            sink += get_cached_summary(&cache, 17, (CacheColumn)(i % READING_CACHE_COLUMNS), &s) + s.mean;
+        });
+    }
+
+    {
+        static gateway_merge_t merge;
+        init_gateway_merge(&merge, 0, 0);
+        bench("merge_packet x2 + merge_poll", 0, [](uint32_t i) {
+            const packet_t *p = &samples[i % SAMPLES];
+            merged_packet_t out;
+            merge_packet(&merge, p, 1, -100, i);
+            merge_packet(&merge, p, 2, -90, i);
+            sink += merge_poll(&merge, i, &out) + out.rssi;
+        });
+    }
+
+    return sink == 0xdeadbeef;
+}
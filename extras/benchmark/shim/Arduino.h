@@ -0,0 +1,27 @@
+// Just enough of Arduino.h to build the library on a host computer.
+
+#ifndef h_arduino_shim_h
+#define h_arduino_shim_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+inline unsigned long micros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+#endif
@@ -0,0 +1,16 @@
+// Just enough of RadioHead's RH_RF95.h to build the library on a host computer.
+
+#ifndef h_rh_rf95_shim_h
+#define h_rh_rf95_shim_h
+
+#include <Arduino.h>
+
+#define RH_RF95_MAX_MESSAGE_LEN 251
+
+class RH_RF95 {
+public:
+    void setSpreadingFactor(uint8_t sf) { (void)sf; }
+    void setTxPower(int8_t power, bool useRFO = false) { (void)power; (void)useRFO; }
+};
+
+#endif
@@ -0,0 +1,43 @@
+// Host tests for the library.
+//
+// Each test encodes values, decodes them again and checks that what
+// comes out is what went in, or drives a module through its edge cases.
+// The program prints each failed check and exits non-zero if any
+// failed.
+
+#include "test.h"
+
+int test_checks;
+int test_failures;
+
+int main() {
+    test_data_packet_csv();
+    test_varint();
+    test_crc();
+    test_delta();
+    test_bit_pack();
+    test_fragment();
+    test_build_data_packet();
+    test_message_views();
+    test_dispatcher();
+    test_data_log();
+    test_sector_writer();
+    test_join_table();
+    test_join_snapshot();
+    test_sequence_tracker();
+    test_rx_queue();
+    test_store_forward();
+    test_schema_codecs();
+    test_timing();
+    test_leaf_config();
+    test_slot_schedule();
+    test_time_sync();
+    test_ack_bitmap();
+    test_reading_cache();
+    test_data_summary();
+    test_gateway_merge();
+    test_join_protocol();
+
+    printf("%d checks, %d failed\n", test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+// Shared by the host tests: the CHECK() macro and the list of tests.
+
+#ifndef h_test_h
+#define h_test_h
+
+#include <Arduino.h>
+
+extern int test_checks;
+extern int test_failures;
+
+/// Count a check and print it if it failed; the tests keep going
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        ++test_checks;                                                  \
+        if (!(cond)) {                                                  \
+            ++test_failures;                                            \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                               \
+    } while (0)
+
+/** @name test_codecs.cc */
+///@{
+void test_data_packet_csv();
+void test_varint();
+void test_crc();
+void test_delta();
+void test_bit_pack();
+void test_fragment();
+///@}
+
+/** @name test_data_packet.cc */
+///@{
+void test_build_data_packet();
+///@}
+
+/** @name test_views.cc */
+///@{
+void test_message_views();
+///@}
+
+/** @name test_dispatcher.cc */
+///@{
+void test_dispatcher();
+///@}
+
+/** @name test_data_log.cc */
+///@{
+void test_data_log();
+///@}
+
+/** @name test_sector_writer.cc */
+///@{
+void test_sector_writer();
+///@}
+
+/** @name test_join_table.cc */
+///@{
+void test_join_table();
+///@}
+
+/** @name test_join_snapshot.cc */
+///@{
+void test_join_snapshot();
+///@}
+
+/** @name test_sequence_tracker.cc */
+///@{
+void test_sequence_tracker();
+///@}
+
+/** @name test_rx_queue.cc */
+///@{
+void test_rx_queue();
+///@}
+
+/** @name test_store_forward.cc */
+///@{
+void test_store_forward();
+///@}
+
+/** @name test_schema.cc */
+///@{
+void test_schema_codecs();
+///@}
+
+/** @name test_timing.cc */
+///@{
+void test_timing();
+///@}
+
+/** @name test_leaf_config.cc */
+///@{
+void test_leaf_config();
+///@}
+
+/** @name test_slot_schedule.cc */
+///@{
+void test_slot_schedule();
+///@}
+
+/** @name test_time_sync.cc */
+///@{
+void test_time_sync();
+///@}
+
+/** @name test_ack_bitmap.cc */
+///@{
+void test_ack_bitmap();
+///@}
+
+/** @name test_reading_cache.cc */
+///@{
+void test_reading_cache();
+///@}
+
+/** @name test_data_summary.cc */
+///@{
+void test_data_summary();
+///@}
+
+/** @name test_gateway_merge.cc */
+///@{
+void test_gateway_merge();
+///@}
+
+/** @name test_join_protocol.cc */
+///@{
+void test_join_protocol();
+///@}
+
+#endif
@@ -0,0 +1,80 @@
+// Tests for the ack_bitmap broadcast.
+
+#include "test.h"
+
+#include "ack_bitmap.h"
+
+void test_ack_bitmap() {
+    ack_bitmap_t a;
+    build_ack_bitmap(&a, 0, 1615680000);
+    CHECK(ACK_BITMAP_SIZE(&a) == ACK_BITMAP_HEADER_SIZE);
+    CHECK(!ack_bitmap_acks(&a, 3, 10));
+
+    // The newest message, earlier ones and the edge of the window
+    CHECK(add_ack_bitmap_entry(&a, 3, 10));
+    CHECK(ack_bitmap_acks(&a, 3, 10) && !ack_bitmap_acks(&a, 3, 9) && !ack_bitmap_acks(&a, 3, 11));
+    CHECK(add_ack_bitmap_entry(&a, 3, 10 - ACK_BITMAP_WINDOW));
+    CHECK(!add_ack_bitmap_entry(&a, 3, 10 - ACK_BITMAP_WINDOW - 1));
+    CHECK(ack_bitmap_acks(&a, 3, 10 - ACK_BITMAP_WINDOW) && !ack_bitmap_acks(&a, 3, 10 - ACK_BITMAP_WINDOW - 1));
+    CHECK(add_ack_bitmap_entry(&a, 3, 10) && a.count == 1 && a.acks[0].bitmap == 0x80);
+
+    // A newer message slides the bitmap; a jump past the window clears it
+    CHECK(add_ack_bitmap_entry(&a, 3, 12));
+    CHECK(a.acks[0].message == 12 && a.acks[0].bitmap == 0x02);
+    CHECK(ack_bitmap_acks(&a, 3, 10) && !ack_bitmap_acks(&a, 3, 11) && !ack_bitmap_acks(&a, 3, 2));
+    CHECK(add_ack_bitmap_entry(&a, 3, 12 + ACK_BITMAP_WINDOW + 1));
+    CHECK(a.acks[0].bitmap == 0 && !ack_bitmap_acks(&a, 3, 12));
+
+    // Message numbers are compared on their low 16 bits and wrap
+    build_ack_bitmap(&a, 0, 0);
+    CHECK(add_ack_bitmap_entry(&a, 4, 0x1fffe));
+    CHECK(add_ack_bitmap_entry(&a, 4, 0x20001));
+    CHECK(a.acks[0].message == 0x0001 && a.acks[0].bitmap == 0x04);
+    CHECK(ack_bitmap_acks(&a, 4, 0x2fffe) && ack_bitmap_acks(&a, 4, 0x20001) && !ack_bitmap_acks(&a, 4, 0x1ffff));
+    CHECK(ack_entry_acks(0x0001, 0xff, 0xfff9) && !ack_entry_acks(0x0001, 0xff, 0xfff8));
+
+    // A full ack_bitmap still updates the nodes it has
+    build_ack_bitmap(&a, 0, 0);
+    uint8_t added = 0;
+    for (uint8_t node = 1; node <= ACK_BITMAP_MAX_ENTRIES; ++node)
+        added += add_ack_bitmap_entry(&a, node, node);
+    CHECK(added == ACK_BITMAP_MAX_ENTRIES && a.count == ACK_BITMAP_MAX_ENTRIES);
+    CHECK(!add_ack_bitmap_entry(&a, ACK_BITMAP_MAX_ENTRIES + 1, 1));
+    CHECK(add_ack_bitmap_entry(&a, ACK_BITMAP_MAX_ENTRIES, ACK_BITMAP_MAX_ENTRIES + 1));
+    CHECK(ack_bitmap_acks(&a, ACK_BITMAP_MAX_ENTRIES, ACK_BITMAP_MAX_ENTRIES));
+    CHECK(!ack_bitmap_acks(&a, ACK_BITMAP_MAX_ENTRIES + 1, 1));
+
+    // Parse, with and without a CRC trailer
+    uint8_t node = 0xff, count = 0;
+    uint32_t time = 0;
+    uint8_t len = (uint8_t)ACK_BITMAP_SIZE(&a);
+    CHECK(parse_ack_bitmap(&a, len, &node, &time, &count) && node == 0 && time == 0
+          && count == ACK_BITMAP_MAX_ENTRIES);
+    CHECK(!parse_ack_bitmap(&a, len - 1, 0, 0, 0) && !parse_ack_bitmap(&a, ACK_BITMAP_HEADER_SIZE - 1, 0, 0, 0));
+
+    // A full ack_bitmap fills the frame; one entry fewer leaves room for a CRC
+    uint8_t buf[sizeof(ack_bitmap_t) + MESSAGE_CRC_SIZE];
+    memcpy(buf, &a, len);
+    CHECK(add_message_crc(buf, len, sizeof(buf)) == 0);
+    a.count--;
+    len = (uint8_t)ACK_BITMAP_SIZE(&a);
+    memcpy(buf, &a, len);
+    size_t n = add_message_crc(buf, len, sizeof(buf));
+    CHECK(n == (size_t)len + MESSAGE_CRC_SIZE);
+    CHECK(parse_ack_bitmap((const ack_bitmap_t *)buf, (uint8_t)n, 0, 0, &count)
+          && count == ACK_BITMAP_MAX_ENTRIES - 1);
+    buf[ACK_BITMAP_HEADER_SIZE + 1] ^= 1;
+    CHECK(!parse_ack_bitmap((const ack_bitmap_t *)buf, (uint8_t)n, 0, 0, 0));
+
+    // A count past the end of the message
+    a.count = ACK_BITMAP_MAX_ENTRIES + 1;
+    CHECK(!parse_ack_bitmap(&a, sizeof(ack_bitmap_t), 0, 0, 0));
+    a.count = 2;
+    CHECK(!parse_ack_bitmap(&a, ACK_BITMAP_HEADER_SIZE + 4, 0, 0, 0));
+
+    char str[64];
+    build_ack_bitmap(&a, 0, 1615680000);
+    add_ack_bitmap_entry(&a, 3, 10);
+    CHECK(ack_bitmap_to_string(&a, str, sizeof(str)) == 16 && strcmp(str, "0, 1615680000, 1") == 0);
+    CHECK(ack_bitmap_to_string(&a, str, 4) == 3);
+}
@@ -0,0 +1,295 @@
+// Round trip tests for the data packet codecs and the CSV formatter.
+
+#include "test.h"
+
+#include "messages.h"
+#include "data_packet.h"
+#include "delta_packet.h"
+#include "varint.h"
+#include "crc16.h"
+#include "bit_pack.h"
+#include "packed_packet.h"
+#include "fragment.h"
+
+/**
+ * Packets with each field at zero, at its limits and at typical values.
+ */
+static const packet_t *edge_packets(size_t *count) {
+    static packet_t packets[6];
+
+    build_data_packet(&packets[0], 0, 0, 0, 0, 0, 0, 0, 0);
+    build_data_packet(&packets[1], 0xff, 0xffffffff, 0xffffffff, 0xffff, 0xffff, -1, 0xffff, 0xff);
+    build_data_packet(&packets[2], 17, 1234, 1615680000, 395, 1000, -420, 6250, 3);
+    build_data_packet(&packets[3], 1, 1, 1, 1, 1, -32768, 1, 1);
+    build_data_packet(&packets[4], 2, 99, 1600000000, 371, 88, 32767, 5512, 0xab);
+    build_data_packet(&packets[5], 3, 100, 1600000600, 370, 89, -5, 10000, 0x10);
+
+    *count = sizeof(packets) / sizeof(packets[0]);
+    return packets;
+}
+
+/**
+ * data_packet_to_csv() must print the same line as the snprintf()
+ * format the non-pretty data_packet_to_string() used to use.
+ */
+void test_data_packet_csv() {
+    size_t count;
+    const packet_t *packets = edge_packets(&count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const packet_t *p = &packets[i];
+        char expected[DATA_PACKET_STRING_LEN];
+        char csv[DATA_PACKET_CSV_LEN];
+        char str[DATA_PACKET_STRING_LEN];
+
+        int n = snprintf(expected, sizeof(expected), "%u, %lu, %lu, %u, %u, %d, %u, 0x%02x",
+                         p->node, (unsigned long)p->message, (unsigned long)p->time, p->battery,
+                         p->last_tx_duration, p->temp, p->humidity, (unsigned int)p->status);
+
+        CHECK(data_packet_to_csv(p, csv, sizeof(csv)) == (size_t)n);
+        CHECK(strcmp(csv, expected) == 0);
+        CHECK(data_packet_to_string(p, str, sizeof(str)) == (size_t)n);
+        CHECK(strcmp(str, expected) == 0);
+
+        // A short buffer gets the start of the same line
+        char small[12];
+        CHECK(data_packet_to_csv(p, small, sizeof(small)) == sizeof(small) - 1);
+        CHECK(strncmp(small, expected, sizeof(small) - 1) == 0 && small[sizeof(small) - 1] == '\0');
+    }
+
+    packet_t p;
+    char csv[DATA_PACKET_CSV_LEN];
+    build_data_packet(&p, 9, 1, 2, 371, 88, -425, 5, 0);
+    data_packet_to_csv(&p, csv, sizeof(csv), true);
+    CHECK(strcmp(csv, "9, 1, 2, 3.71, 88, -4.25, 0.05, 0x00") == 0);
+    build_data_packet(&p, 9, 1, 2, 0, 88, -5, 0, 0);
+    data_packet_to_csv(&p, csv, sizeof(csv), true);
+    CHECK(strcmp(csv, "9, 1, 2, 0.00, 88, -0.05, 0.00, 0x00") == 0);
+}
+
+void test_varint() {
+    static const uint32_t values[] = {0, 1, 127, 128, 16383, 16384, 0x1fffff, 0x200000, 0x7fffffff, 0xffffffff};
+    uint8_t buf[VARINT_MAX_LEN];
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        uint8_t n = put_varint(buf, values[i]);
+        CHECK(n >= 1 && n <= VARINT_MAX_LEN);
+
+        uint32_t v = 0;
+        CHECK(get_varint(buf, n, &v) == n && v == values[i]);
+        // Truncated
+        CHECK(get_varint(buf, n - 1, &v) == 0);
+    }
+    CHECK(put_varint(buf, 127) == 1);
+    CHECK(put_varint(buf, 128) == 2);
+    CHECK(put_varint(buf, 0xffffffff) == VARINT_MAX_LEN);
+
+    static const int32_t signed_values[] = {0, -1, 1, -2, 2, -32768, 32767, INT32_MIN, INT32_MAX};
+    for (size_t i = 0; i < sizeof(signed_values) / sizeof(signed_values[0]); ++i)
+        CHECK(zigzag_decode(zigzag_encode(signed_values[i])) == signed_values[i]);
+    CHECK(zigzag_encode(0) == 0 && zigzag_encode(-1) == 1 && zigzag_encode(1) == 2 && zigzag_encode(-2) == 3);
+}
+
+void test_crc() {
+    CHECK(crc16((const uint8_t *)"123456789", 9) == 0x29b1);
+
+    // Computing the CRC in pieces gives the same result
+    uint8_t data[64];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 37 + 11);
+    CHECK(crc16(data + 20, sizeof(data) - 20, crc16(data, 20)) == crc16(data, sizeof(data)));
+
+    time_response_t msg;
+    build_time_response(&msg, 3, 1615680000);
+
+    uint8_t buf[TIME_RESPONSE_SIZE + MESSAGE_CRC_SIZE];
+    memcpy(buf, &msg, TIME_RESPONSE_SIZE);
+    CHECK(add_message_crc(buf, TIME_RESPONSE_SIZE, TIME_RESPONSE_SIZE) == 0);
+    CHECK(add_message_crc(buf, TIME_RESPONSE_SIZE, sizeof(buf)) == sizeof(buf));
+    CHECK(message_has_crc(buf));
+    CHECK(check_message_frame(buf, sizeof(buf), TIME_RESPONSE_SIZE));
+    CHECK(!check_message_frame(buf, sizeof(buf) - 1, TIME_RESPONSE_SIZE));
+
+    uint8_t node;
+    uint32_t time;
+    CHECK(parse_time_response((const time_response_t *)buf, sizeof(buf), &node, &time));
+    CHECK(node == 3 && time == 1615680000);
+
+    // Any single bit error is caught
+    for (size_t i = 1; i < sizeof(buf); ++i) {
+        for (uint8_t bit = 0; bit < 8; ++bit) {
+            buf[i] ^= (uint8_t)(1 << bit);
+            CHECK(!check_message_frame(buf, sizeof(buf), TIME_RESPONSE_SIZE));
+            buf[i] ^= (uint8_t)(1 << bit);
+        }
+    }
+}
+
+void test_delta() {
+    delta_encoder_t enc;
+    delta_decoder_t dec;
+    init_delta_encoder(&enc);
+    init_delta_decoder(&dec);
+
+    uint8_t buf[DELTA_PACKET_MAX_SIZE];
+    bool keyframe_after_interval = false;
+
+    for (uint32_t i = 0; i < 3 * DELTA_KEYFRAME_INTERVAL; ++i) {
+        packet_t p;
+        build_data_packet(&p, 7, 100 + i, 1600000000 + 600 * i, 371 - (i % 3), 120 + i, -425 + (int)i * 3,
+                          5500 + i * 7, i % 2);
+        p.data = (uint8_t)i;
+
+        uint8_t n = build_delta_packet(&enc, buf, &p);
+        CHECK(n <= DELTA_PACKET_MAX_SIZE);
+        if (i == DELTA_KEYFRAME_INTERVAL)
+            keyframe_after_interval = (buf[2] & DELTA_KEYFRAME) != 0;
+
+        packet_t q;
+        CHECK(parse_delta_packet(&dec, buf, n, &q));
+        CHECK(memcmp(&p, &q, sizeof(packet_t)) == 0);
+
+        delta_packet_acked(&enc, &p);
+    }
+    CHECK(keyframe_after_interval);
+
+    // The edge values survive a keyframe and a delta from another edge
+    size_t count;
+    const packet_t *packets = edge_packets(&count);
+    init_delta_encoder(&enc);
+    init_delta_decoder(&dec);
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t n = build_delta_packet(&enc, buf, &packets[i]);
+        CHECK(n <= DELTA_PACKET_MAX_SIZE);
+
+        packet_t q;
+        CHECK(parse_delta_packet(&dec, buf, n, &q));
+        packet_t expected = packets[i];
+        expected.type = data_packet;
+        CHECK(memcmp(&expected, &q, sizeof(packet_t)) == 0);
+
+        delta_packet_acked(&enc, &packets[i]);
+    }
+
+    // A delta against a packet the decoder never saw is rejected
+    packet_t p = packets[2];
+    init_delta_decoder(&dec);
+    p.message++;
+    uint8_t n = build_delta_packet(&enc, buf, &p);
+    packet_t q;
+    CHECK((buf[2] & DELTA_KEYFRAME) == 0 && !parse_delta_packet(&dec, buf, n, &q));
+}
+
+void test_bit_pack() {
+    uint8_t buf[16];
+    memset(buf, 0, sizeof(buf));
+
+    bit_writer_t w;
+    init_bit_writer(&w, buf);
+    put_bits(&w, 5, 3);
+    put_bits(&w, 0xabcd, 16);
+    put_bits(&w, 0xdeadbeef, 32);
+    put_bits(&w, 1, 1);
+    put_bits(&w, 0, 7);
+    put_bits(&w, 0x1ffff, 17);
+    CHECK(w.bit == 76);
+
+    bit_reader_t r;
+    init_bit_reader(&r, buf, BIT_PACK_BYTES(w.bit));
+    uint32_t v;
+    CHECK(get_bits(&r, 3, &v) && v == 5);
+    CHECK(get_bits(&r, 16, &v) && v == 0xabcd);
+    CHECK(get_bits(&r, 32, &v) && v == 0xdeadbeef);
+    CHECK(get_bits(&r, 1, &v) && v == 1);
+    CHECK(get_bits(&r, 7, &v) && v == 0);
+    CHECK(get_bits(&r, 17, &v) && v == 0x1ffff);
+    // Only the padding to the byte boundary is left
+    CHECK(get_bits(&r, 4, &v) && v == 0);
+    CHECK(!get_bits(&r, 1, &v));
+
+    // The packed data packet built on top of it
+    packet_t p, q;
+    build_data_packet(&p, 17, 1234, 1615680000, 395, 1000, -420, 6250, 3);
+    p.data = 9;
+    uint8_t frame[PACKED_PACKET_MAX_SIZE];
+    uint8_t n = build_packed_packet(frame, &p);
+    CHECK(n == packed_packet_size(&default_packed_format));
+    CHECK(parse_packed_packet(frame, n, &q));
+    CHECK(memcmp(&p, &q, sizeof(packet_t)) == 0);
+    CHECK(!parse_packed_packet(frame, n - 1, &q));
+}
+
+void test_fragment() {
+    static uint8_t data[3000];
+    static uint8_t out[FRAGMENT_MAX_TRANSFER];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 7 + 1);
+
+    CHECK(get_fragment_count(0) == 1);
+    CHECK(get_fragment_count(FRAGMENT_PAYLOAD_SIZE) == 1);
+    CHECK(get_fragment_count(FRAGMENT_PAYLOAD_SIZE + 1) == 2);
+    CHECK(get_fragment_count(FRAGMENT_MAX_TRANSFER) == FRAGMENT_MAX_COUNT);
+    CHECK(get_fragment_count(FRAGMENT_MAX_TRANSFER + 1) == 0);
+
+    reassembly_t r;
+    init_reassembly(&r, out, sizeof(out));
+
+    uint8_t frame[RH_RF95_MAX_MESSAGE_LEN];
+    uint8_t count = get_fragment_count(sizeof(data));
+    CHECK(build_fragment(frame, 9, 42, data, sizeof(data), count) == 0);
+
+    // Send the fragments out of order and lose two of them
+    for (uint8_t i = count; i-- > 0;) {
+        if (i == 0 || i == 5)
+            continue;
+        uint8_t n = build_fragment(frame, 9, 42, data, sizeof(data), i);
+        size_t m = add_message_crc(frame, n, sizeof(frame));
+        CHECK(m == (size_t)n + MESSAGE_CRC_SIZE);
+        CHECK(add_fragment(&r, frame, (uint8_t)m) == fragment_added);
+    }
+    CHECK(get_missing_fragments(&r) == ((1u << 0) | (1u << 5)));
+
+    fragment_nack_t nack;
+    build_fragment_nack(&nack, &r);
+    uint8_t node, id;
+    uint32_t missing;
+    CHECK(parse_fragment_nack(&nack, FRAGMENT_NACK_SIZE, &node, &id, &missing));
+    CHECK(node == 9 && id == 42 && missing == ((1u << 0) | (1u << 5)));
+
+    uint8_t n = build_fragment(frame, 9, 42, data, sizeof(data), 3);
+    CHECK(add_fragment(&r, frame, n) == fragment_duplicate);
+    n = build_fragment(frame, 9, 42, data, sizeof(data), 5);
+    CHECK(add_fragment(&r, frame, n) == fragment_added);
+    n = build_fragment(frame, 9, 42, data, sizeof(data), 0);
+    CHECK(add_fragment(&r, frame, n) == fragment_complete);
+    CHECK(r.length == sizeof(data) && memcmp(out, data, sizeof(data)) == 0);
+
+    CHECK(get_missing_fragments(&r) == 0);
+
+    // The id may be used again once a transfer is complete
+    n = build_fragment(frame, 9, 42, data + 1, 2 * FRAGMENT_PAYLOAD_SIZE, 1);
+    CHECK(add_fragment(&r, frame, n) == fragment_added && get_missing_fragments(&r) == 1);
+    n = build_fragment(frame, 9, 42, data + 1, 2 * FRAGMENT_PAYLOAD_SIZE, 0);
+    CHECK(add_fragment(&r, frame, n) == fragment_complete);
+    CHECK(r.length == 2 * FRAGMENT_PAYLOAD_SIZE && memcmp(out, data + 1, r.length) == 0);
+
+    // A transfer larger than the buffer is refused
+    uint8_t small[300];
+    init_reassembly(&r, small, sizeof(small));
+    n = build_fragment(frame, 1, 1, data, sizeof(data), 2);
+    CHECK(add_fragment(&r, frame, n) == fragment_invalid);
+
+    // ... from its first fragment, if all of its fragments might not fit
+    n = build_fragment(frame, 1, 2, data, sizeof(small), 0);
+    CHECK(add_fragment(&r, frame, n) == fragment_invalid && r.count == 0);
+
+    // ... without abandoning the transfer in progress
+    static uint8_t two[2 * FRAGMENT_PAYLOAD_SIZE];
+    init_reassembly(&r, two, sizeof(two));
+    n = build_fragment(frame, 1, 3, data, sizeof(two) - 1, 0);
+    CHECK(add_fragment(&r, frame, n) == fragment_added);
+    n = build_fragment(frame, 1, 4, data, 3 * FRAGMENT_PAYLOAD_SIZE, 0);
+    CHECK(add_fragment(&r, frame, n) == fragment_invalid && r.id == 3);
+    n = build_fragment(frame, 1, 3, data, sizeof(two) - 1, 1);
+    CHECK(add_fragment(&r, frame, n) == fragment_complete && r.length == sizeof(two) - 1);
+}
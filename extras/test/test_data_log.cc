@@ -0,0 +1,56 @@
+// Tests for the binary data log.
+
+#include "test.h"
+
+#include "data_log.h"
+
+static void count_line(const char *csv, size_t len, void *context) {
+    int *lines = (int *)context;
+    if (len == strlen(csv) && len > 0)
+        (*lines)++;
+}
+
+void test_data_log() {
+    data_log_header_t header;
+    build_data_log_header(&header);
+    CHECK(parse_data_log_header(&header));
+    header.reserved[0] ^= 1;
+    CHECK(!parse_data_log_header(&header));
+
+    // Fill a block to the last record
+    static data_log_block_t block;
+    init_data_log_block(&block, 0xffff);
+    packet_t p;
+    for (uint8_t i = 0; i < DATA_LOG_RECORDS_PER_BLOCK; ++i) {
+        build_data_packet(&p, 17, 1000 + i, 1615680000 + 600 * i, 395, 1000, -420, 6250, i);
+        CHECK(add_data_log_record(&block, &p));
+    }
+    CHECK(!add_data_log_record(&block, &p));
+    finish_data_log_block(&block);
+
+    uint16_t sequence;
+    uint8_t count;
+    CHECK(parse_data_log_block(&block, &sequence, &count));
+    CHECK(sequence == 0xffff && count == DATA_LOG_RECORDS_PER_BLOCK);
+
+    int lines = 0;
+    CHECK(data_log_block_to_csv(&block, count_line, &lines) == DATA_LOG_RECORDS_PER_BLOCK);
+    CHECK(lines == DATA_LOG_RECORDS_PER_BLOCK);
+
+    // A damaged block is refused and produces no lines
+    static data_log_block_t bad;
+    bad = block;
+    bad.records[3].temp ^= 0x100;
+    CHECK(!parse_data_log_block(&bad, 0, 0));
+    lines = 0;
+    CHECK(data_log_block_to_csv(&bad, count_line, &lines) == 0 && lines == 0);
+
+    // Recovery: the next intact block after a damaged one and some junk
+    static uint8_t file[3 * DATA_LOG_BLOCK_SIZE + 7];
+    memset(file, 0x5a, sizeof(file));
+    memcpy(file, &bad, DATA_LOG_BLOCK_SIZE);
+    memcpy(file + DATA_LOG_BLOCK_SIZE + 7, &block, DATA_LOG_BLOCK_SIZE);
+    CHECK(find_data_log_block(file, sizeof(file)) == DATA_LOG_BLOCK_SIZE + 7);
+    CHECK(find_data_log_block(file, DATA_LOG_BLOCK_SIZE + 7 + DATA_LOG_BLOCK_SIZE - 1) == -1);
+    CHECK(find_data_log_block(file, 0) == -1);
+}
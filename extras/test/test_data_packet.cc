@@ -0,0 +1,27 @@
+// Tests for building data packets.
+
+#include "test.h"
+
+#include "data_packet.h"
+
+void test_build_data_packet() {
+    // The same values give the same bytes whatever was in the buffer
+    packet_t a, b;
+    memset(&a, 0x00, sizeof(packet_t));
+    memset(&b, 0xff, sizeof(packet_t));
+    build_data_packet(&a, 17, 1234, 1615680000, 395, 1000, -420, 6250, 3);
+    build_data_packet(&b, 17, 1234, 1615680000, 395, 1000, -420, 6250, 3);
+    CHECK(memcmp(&a, &b, sizeof(packet_t)) == 0);
+    CHECK(a.data == 0);
+    CHECK(get_message_type(&a) == data_packet && !message_has_crc(&a));
+
+    uint8_t node, status;
+    uint32_t message, time;
+    uint16_t battery, last_tx_duration, humidity;
+    int16_t temp;
+    CHECK(parse_data_packet(&a, DATA_PACKET_SIZE, &node, &message, &time, &battery, &last_tx_duration, &temp,
+                            &humidity, &status));
+    CHECK(node == 17 && message == 1234 && time == 1615680000 && battery == 395 && last_tx_duration == 1000
+          && temp == -420 && humidity == 6250 && status == 3);
+    CHECK(!parse_data_packet(&a, DATA_PACKET_SIZE - 1, 0, 0, 0, 0, 0, 0, 0, 0));
+}
@@ -0,0 +1,83 @@
+// Tests for on-node aggregation into data summaries.
+
+#include "test.h"
+
+#include "data_summary.h"
+
+static bool add_sample(data_aggregator_t *agg, uint32_t time, uint16_t battery, int16_t temp, uint16_t moisture,
+                       uint8_t status = 0) {
+    packet_t data;
+    build_data_packet(&data, 0, 0, time, battery, 0, temp, 5000, status);
+    return add_summary_sample(agg, &data, moisture);
+}
+
+void test_data_summary() {
+    data_aggregator_t agg;
+    data_summary_t s;
+    init_data_aggregator(&agg, 7, 600);
+    CHECK(!build_data_summary(&s, &agg, 1));
+
+    // Mean, min and max; a negative mean rounds away from zero
+    CHECK(!add_sample(&agg, 1000, 330, -1, 2000, 0x01));
+    CHECK(!add_sample(&agg, 1300, 320, -2, 2100, 0x04));
+    CHECK(add_sample(&agg, 1600, 310, -2, 2200));
+    CHECK(build_data_summary(&s, &agg, 42));
+    CHECK(s.type == data_summary && s.node == 7 && s.message == 42 && s.time == 1000 && s.duration == 600);
+    CHECK(s.count == 3 && s.status == 0x05);
+    CHECK(s.battery_mean == 320 && s.battery_min == 310 && s.battery_max == 330);
+    CHECK(s.temp_mean == -2 && s.temp_min == -2 && s.temp_max == -1);
+    CHECK(s.humidity_mean == 5000 && s.moisture_mean == 2100 && s.moisture_min == 2000 && s.moisture_max == 2200);
+    CHECK(!build_data_summary(&s, &agg, 43));
+
+    // A jump from the last summary's mean, then from the window's mean
+    set_summary_threshold(&agg, summary_moisture, 500);
+    CHECK(!add_sample(&agg, 2000, 310, 0, 2600));
+    CHECK(add_sample(&agg, 2100, 310, 0, 1000));
+    build_data_summary(&s, &agg, 43);
+    CHECK(add_sample(&agg, 2200, 310, 0, 2400));
+    build_data_summary(&s, &agg, 44);
+    CHECK(!add_sample(&agg, 2300, 310, 0, 2400) && !add_sample(&agg, 2400, 310, 0, 2900));
+    CHECK(add_sample(&agg, 2500, 310, 0, 3200));
+
+    // A full window asks to be sent and drops any more samples
+    init_data_aggregator(&agg, 7, 0xffff);
+    uint8_t sends = 0;
+    for (uint16_t i = 0; i < 254; ++i)
+        sends += add_sample(&agg, i, 300, 0, 0);
+    CHECK(sends == 0);
+    CHECK(add_sample(&agg, 254, 300, 0, 0) && add_sample(&agg, 255, 400, 0, 0));
+    CHECK(build_data_summary(&s, &agg, 1) && s.count == 255 && s.battery_max == 300 && s.duration == 254);
+
+    // A window longer than the duration field can hold
+    init_data_aggregator(&agg, 7, 0xffff);
+    add_sample(&agg, 0, 300, 0, 0);
+    CHECK(add_sample(&agg, 100000, 300, 0, 0));
+    CHECK(build_data_summary(&s, &agg, 1) && s.duration == 0xffff);
+
+    // Parse, with and without a CRC trailer
+    uint8_t node = 0, count = 0;
+    uint32_t message = 0;
+    CHECK(parse_data_summary(&s, DATA_SUMMARY_SIZE, &node, &message, &count) && node == 7 && message == 1
+          && count == 2);
+    CHECK(!parse_data_summary(&s, DATA_SUMMARY_SIZE - 1, 0, 0, 0));
+
+    uint8_t buf[DATA_SUMMARY_SIZE + MESSAGE_CRC_SIZE];
+    memcpy(buf, &s, DATA_SUMMARY_SIZE);
+    size_t n = add_message_crc(buf, DATA_SUMMARY_SIZE, sizeof(buf));
+    CHECK(parse_data_summary((const data_summary_t *)buf, (uint8_t)n, 0, 0, 0));
+    buf[10] ^= 1;
+    CHECK(!parse_data_summary((const data_summary_t *)buf, (uint8_t)n, 0, 0, 0));
+
+    s.type = data_packet;
+    CHECK(!parse_data_summary(&s, DATA_SUMMARY_SIZE, 0, 0, 0));
+
+    // The longest strings fit in DATA_SUMMARY_STRING_LEN
+    data_summary_t big;
+    memset(&big, 0xff, sizeof(big));
+    big.type = data_summary;
+    big.temp_mean = big.temp_min = big.temp_max = -32768;
+    char str[DATA_SUMMARY_STRING_LEN];
+    size_t plain = data_summary_to_string(&big, str, sizeof(str));
+    size_t pretty = data_summary_to_string(&big, str, sizeof(str), true);
+    CHECK(plain > 0 && plain < sizeof(str) && pretty > plain && pretty < sizeof(str));
+}
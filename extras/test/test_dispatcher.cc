@@ -0,0 +1,97 @@
+// Tests for dispatch_message().
+
+#include "test.h"
+
+#include "messages.h"
+#include "data_packet.h"
+#include "delta_packet.h"
+#include "dispatcher.h"
+
+struct dispatch_log_t {
+    int data_packets;
+    int time_responses;
+    int deltas;
+    uint8_t delta_len;
+    int16_t temp;
+};
+
+static void on_data_packet(const data_packet_view &msg, void *context) {
+    dispatch_log_t *log = (dispatch_log_t *)context;
+    log->data_packets++;
+    log->temp = msg.temp();
+}
+
+static void on_time_response(const time_response_view &msg, void *context) {
+    dispatch_log_t *log = (dispatch_log_t *)context;
+    log->time_responses++;
+    log->temp = (int16_t)msg.node();
+}
+
+static void on_data_delta(const uint8_t *buf, uint8_t len, void *context) {
+    dispatch_log_t *log = (dispatch_log_t *)context;
+    log->deltas++;
+    log->delta_len = len;
+
+    delta_decoder_t dec;
+    init_delta_decoder(&dec);
+    packet_t p;
+    if (parse_delta_packet(&dec, buf, len, &p))
+        log->temp = p.temp;
+}
+
+void test_dispatcher() {
+    message_handlers_t handlers;
+    memset(&handlers, 0, sizeof(handlers));
+    handlers.on_data_packet = on_data_packet;
+    handlers.on_time_response = on_time_response;
+    handlers.on_data_delta = on_data_delta;
+
+    dispatch_log_t log;
+    memset(&log, 0, sizeof(log));
+
+    uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
+    packet_t p;
+    build_data_packet(&p, 17, 1234, 1615680000, 395, 1000, -420, 6250, 3);
+    memcpy(buf, &p, DATA_PACKET_SIZE);
+
+    CHECK(dispatch_message(&handlers, buf, DATA_PACKET_SIZE, &log));
+    CHECK(log.data_packets == 1 && log.temp == -420);
+
+    // Empty, truncated, or a type with no handler
+    CHECK(!dispatch_message(&handlers, buf, 0, &log));
+    CHECK(!dispatch_message(&handlers, buf, DATA_PACKET_SIZE - 1, &log));
+    time_request_t treq;
+    build_time_request(&treq, 5);
+    CHECK(!dispatch_message(&handlers, (const uint8_t *)&treq, TIME_REQUEST_SIZE, &log));
+    // An unknown type
+    buf[0] = 0x7f;
+    CHECK(!dispatch_message(&handlers, buf, DATA_PACKET_SIZE, &log));
+    CHECK(log.data_packets == 1);
+
+    // With a CRC trailer; a bad CRC is dropped before the handler
+    memcpy(buf, &p, DATA_PACKET_SIZE);
+    size_t n = add_message_crc(buf, DATA_PACKET_SIZE, sizeof(buf));
+    CHECK(n == DATA_PACKET_SIZE + MESSAGE_CRC_SIZE);
+    CHECK(dispatch_message(&handlers, buf, (uint8_t)n, &log) && log.data_packets == 2);
+    buf[5] ^= 0x10;
+    CHECK(!dispatch_message(&handlers, buf, (uint8_t)n, &log) && log.data_packets == 2);
+    CHECK(!dispatch_message(&handlers, buf, MESSAGE_CRC_SIZE, &log));
+
+    time_response_t tr;
+    build_time_response(&tr, 9, 1615680000);
+    memcpy(buf, &tr, TIME_RESPONSE_SIZE);
+    n = add_message_crc(buf, TIME_RESPONSE_SIZE, sizeof(buf));
+    CHECK(dispatch_message(&handlers, buf, (uint8_t)n, &log));
+    CHECK(log.time_responses == 1 && log.temp == 9);
+
+    // A variable length message's handler gets the whole frame, trailer included
+    delta_encoder_t enc;
+    init_delta_encoder(&enc);
+    n = build_delta_packet(&enc, buf, &p);
+    n = add_message_crc(buf, n, sizeof(buf));
+    log.temp = 0;
+    CHECK(dispatch_message(&handlers, buf, (uint8_t)n, &log));
+    CHECK(log.deltas == 1 && log.delta_len == n && log.temp == -420);
+    buf[n - 1] ^= 1;
+    CHECK(!dispatch_message(&handlers, buf, (uint8_t)n, &log) && log.deltas == 1);
+}
@@ -0,0 +1,80 @@
+// Tests for merging packets from several gateways.
+
+#include "test.h"
+
+#include "gateway_merge.h"
+
+static packet_t make_packet(uint8_t node, uint32_t message) {
+    packet_t data;
+    build_data_packet(&data, node, message, 1615680000 + message, 330, 0, 2000, 5000, 0);
+    return data;
+}
+
+void test_gateway_merge() {
+    static gateway_merge_t merge;
+    merged_packet_t out;
+    init_gateway_merge(&merge, 100, 1000);
+    CHECK(!merge_poll(&merge, 0, &out));
+
+    // Three gateways, one twice; the best RSSI is kept
+    packet_t p = make_packet(5, 1);
+    CHECK(merge_packet(&merge, &p, 0, -90, 10) == merge_new);
+    CHECK(merge_packet(&merge, &p, 1, -80, 20) == merge_better);
+    CHECK(merge_packet(&merge, &p, 1, -70, 30) == merge_better);
+    CHECK(merge_packet(&merge, &p, 2, -100, 40) == merge_duplicate);
+    CHECK(!merge_poll(&merge, 109, &out));
+    CHECK(merge_poll(&merge, 110, &out) && out.gateway == 1 && out.rssi == -70 && out.copies == 3);
+    CHECK(out.packet.node == 5 && out.packet.message == 1);
+    CHECK(!merge_poll(&merge, 110, &out));
+
+    // A late copy is a duplicate until forget_ms, then a new packet
+    CHECK(merge_packet(&merge, &p, 3, -50, 500) == merge_duplicate);
+    CHECK(merge_packet(&merge, &p, 3, -50, 1010) == merge_new);
+
+    // Packets come out in the order they were first seen, not slot order
+    init_gateway_merge(&merge, 100, 150);
+    p = make_packet(1, 1);
+    merge_packet(&merge, &p, 0, -90, 0);
+    CHECK(merge_poll(&merge, 100, &out) && out.packet.node == 1);
+    p = make_packet(2, 1);
+    merge_packet(&merge, &p, 0, -90, 120);
+    p = make_packet(3, 1);
+    CHECK(merge_packet(&merge, &p, 0, -90, 200) == merge_new && merge.entries[0].best.packet.node == 3);
+    CHECK(merge_poll(&merge, 300, &out) && out.packet.node == 2);
+    CHECK(merge_poll(&merge, 300, &out) && out.packet.node == 3);
+
+    // The clock wraps between copies
+    init_gateway_merge(&merge, 100, 1000);
+    p = make_packet(4, 9);
+    CHECK(merge_packet(&merge, &p, 0, -90, 0xffffffc0) == merge_new);
+    CHECK(!merge_poll(&merge, 0x10, &out) && merge_poll(&merge, 0x30, &out));
+
+    // All slots held: full. Once released, the oldest is forgotten first
+    init_gateway_merge(&merge, 100, 1000);
+    uint8_t added = 0;
+    for (uint8_t i = 0; i < MERGE_CACHE_SLOTS; ++i) {
+        p = make_packet(i, 1);
+        added += merge_packet(&merge, &p, 0, -90, 300 - i) == merge_new;
+    }
+    CHECK(added == MERGE_CACHE_SLOTS);
+    p = make_packet(100, 1);
+    CHECK(merge_packet(&merge, &p, 0, -90, 300) == merge_full);
+
+    uint8_t released = 0;
+    bool in_order = true;
+    uint8_t last = MERGE_CACHE_SLOTS;
+    while (merge_poll(&merge, 400, &out)) {
+        in_order = in_order && out.packet.node < last;
+        last = out.packet.node;
+        released++;
+    }
+    CHECK(released == MERGE_CACHE_SLOTS && in_order);
+
+    CHECK(merge_packet(&merge, &p, 0, -90, 400) == merge_new);
+    p = make_packet(MERGE_CACHE_SLOTS - 1, 1);
+    CHECK(merge_packet(&merge, &p, 0, -90, 400) == merge_new);
+    p = make_packet(MERGE_CACHE_SLOTS - 3, 1);
+    CHECK(merge_packet(&merge, &p, 0, -90, 400) == merge_duplicate);
+    p = make_packet(MERGE_CACHE_SLOTS - 2, 1);
+    CHECK(merge_packet(&merge, &p, 0, -90, 400) == merge_new);
+}
@@ -0,0 +1,60 @@
+// Tests for protocol negotiation in the join messages and airtime estimates.
+
+#include "test.h"
+
+#include "messages.h"
+#include "message_views.h"
+#include "dispatcher.h"
+#include "airtime.h"
+
+static int joins;
+
+static void on_join(const join_request_view &msg, void *) {
+    joins += msg.valid();
+}
+
+void test_join_protocol() {
+    // Against the SX1276 datasheet formula; 20 bytes plus RH_RF95's 4
+    CHECK(lora_airtime_us(20) == 61696);
+    CHECK(lora_airtime_us(20, 12) == 1482752);
+    CHECK(lora_airtime_us(20, 7, 250000) == 61696 / 2);
+    CHECK(lora_airtime_us(0) < lora_airtime_us(20) && lora_airtime_us(251) > lora_airtime_us(240));
+
+    // Fewer, fuller frames win; a batch of one does not
+    CHECK(choose_data_encoding(PROTOCOL_CAPABILITIES) == data_batch);
+    CHECK(choose_data_encoding(PROTOCOL_CAPABILITIES, PROTOCOL_CAPABILITIES, 20, 12) == data_batch);
+    CHECK(choose_data_encoding(PROTOCOL_CAPABILITIES, PROTOCOL_CAPABILITIES, 1) == data_delta);
+    CHECK(choose_data_encoding(PROTOCOL_CAPABILITIES, PROTOCOL_CAPABILITIES & ~CAPABILITY_BATCH) == data_delta);
+    CHECK(choose_data_encoding(CAPABILITY_PACKED) == data_packed);
+    CHECK(choose_data_encoding(CAPABILITY_BATCH | CAPABILITY_PACKED, PROTOCOL_CAPABILITIES, 1) == data_packed);
+    CHECK(choose_data_encoding(0) == data_packet && choose_data_encoding(PROTOCOL_CAPABILITIES, 0) == data_packet);
+
+    // A join request from an older protocol is refused; a newer one is answered
+    message_handlers_t handlers;
+    memset(&handlers, 0, sizeof(handlers));
+    handlers.on_join_request = on_join;
+
+    uint8_t buf[JOIN_REQUEST_SIZE + 1];
+    join_request_t *jr = (join_request_t *)buf;
+    build_join_request(jr, 0x0123456789abcdefULL, CAPABILITY_BATCH);
+    uint8_t protocol = 0, capabilities = 0;
+    CHECK(parse_join_request(jr, JOIN_REQUEST_SIZE, 0, &protocol, &capabilities));
+    CHECK(protocol == PROTOCOL_VERSION && capabilities == CAPABILITY_BATCH);
+
+    jr->protocol = PROTOCOL_MIN_VERSION - 1;
+    CHECK(!parse_join_request(jr, JOIN_REQUEST_SIZE, 0, 0, 0));
+    CHECK(!join_request_view(buf, JOIN_REQUEST_SIZE).valid());
+    CHECK(!dispatch_message(&handlers, buf, JOIN_REQUEST_SIZE, 0) && joins == 0);
+
+    char str[96];
+    join_request_to_string(jr, str, sizeof(str), true);
+    CHECK(strstr(str, "protocol: 0,") != 0);
+
+    // A newer leaf may send fields this library doesn't know about
+    jr->protocol = PROTOCOL_VERSION + 1;
+    buf[JOIN_REQUEST_SIZE] = 0x5a;
+    uint64_t dev_eui = 0;
+    CHECK(parse_join_request(jr, sizeof(buf), &dev_eui, &protocol, 0));
+    CHECK(dev_eui == 0x0123456789abcdefULL && protocol == PROTOCOL_VERSION + 1);
+    CHECK(dispatch_message(&handlers, buf, sizeof(buf), 0) && joins == 1);
+}
@@ -0,0 +1,75 @@
+// Tests for saving and loading the join table.
+
+#include "test.h"
+
+#include "join_table.h"
+
+struct test_storage_t {
+    uint8_t data[sizeof(join_table_image_t) + 8 * JOIN_TABLE_LAST_NODE];
+    int writes;
+    int fail_after;     // fail every write once this many have been made; -1 never
+};
+
+static bool storage_read(uint32_t address, void *buf, size_t len, void *context) {
+    test_storage_t *s = (test_storage_t *)context;
+    if (address + len > sizeof(s->data))
+        return false;
+    memcpy(buf, s->data + address, len);
+    return true;
+}
+
+static bool storage_write(uint32_t address, const void *buf, size_t len, void *context) {
+    test_storage_t *s = (test_storage_t *)context;
+    if (address + len > sizeof(s->data) || (s->fail_after >= 0 && s->writes >= s->fail_after))
+        return false;
+    memcpy(s->data + address, buf, len);
+    s->writes++;
+    return true;
+}
+
+void test_join_snapshot() {
+    static test_storage_t s;
+    memset(&s, 0xff, sizeof(s.data));
+    s.writes = 0;
+    s.fail_after = -1;
+    const storage_t storage = {storage_read, storage_write, &s};
+
+    static join_table_t table, loaded;
+    init_join_table(&table);
+
+    // Nothing saved yet
+    CHECK(!join_table_load(&loaded, &storage, 0));
+    CHECK(join_table_assign(&loaded, 0x1234) == 1);
+
+    // An empty table, then a full one
+    CHECK(join_table_save(&table, &storage, 0));
+    CHECK(join_table_load(&loaded, &storage, 0) && loaded.next_node == 1);
+    for (uint16_t i = 1; i <= JOIN_TABLE_LAST_NODE; ++i)
+        join_table_assign(&table, 0x70b3d57ed0000000ull + i);
+    CHECK(join_table_save(&table, &storage, 0));
+    CHECK(join_table_load(&loaded, &storage, 0));
+    CHECK(memcmp(loaded.slots, table.slots, sizeof(table.slots)) == 0);
+    CHECK(join_table_lookup(&loaded, 0x70b3d57ed0000000ull + 200) == 200);
+    CHECK(join_table_assign(&loaded, 0x1234) == 0);
+
+    // A reset between the EUIs and the header loads the previous
+    // snapshot without the newest node
+    init_join_table(&table);
+    join_table_assign(&table, 0x1001);
+    join_table_assign(&table, 0x1002);
+    CHECK(join_table_save(&table, &storage, 0));
+    join_table_assign(&table, 0x1003);
+    s.writes = 0;
+    s.fail_after = 1;
+    CHECK(!join_table_save(&table, &storage, 0));
+    s.fail_after = -1;
+    CHECK(join_table_load(&loaded, &storage, 0));
+    CHECK(loaded.next_node == 3 && join_table_lookup(&loaded, 0x1002) == 2);
+    CHECK(join_table_lookup(&loaded, 0x1003) == 0);
+
+    // A damaged EUI fails the CRC and leaves the table empty
+    CHECK(join_table_save(&table, &storage, 0));
+    s.data[sizeof(join_table_image_t) + 3] ^= 1;
+    CHECK(!join_table_load(&loaded, &storage, 0));
+    CHECK(loaded.next_node == 1 && join_table_lookup(&loaded, 0x1001) == 0);
+}
@@ -0,0 +1,36 @@
+// Tests for the main node's join table.
+
+#include "test.h"
+
+#include "join_table.h"
+
+/// EUIs from one manufacturer share their high bytes
+static uint64_t test_eui(uint16_t i) {
+    return 0x70b3d57ed0000000ull | (uint64_t)(i * 7 + 1);
+}
+
+void test_join_table() {
+    static join_table_t table;
+    init_join_table(&table);
+
+    CHECK(join_table_assign(&table, 0) == 0);
+    CHECK(join_table_lookup(&table, 0) == 0);
+    CHECK(join_table_lookup(&table, test_eui(0)) == 0);
+
+    // Node numbers are handed out in order until the table is full
+    for (uint16_t i = 0; i < JOIN_TABLE_LAST_NODE; ++i)
+        CHECK(join_table_assign(&table, test_eui(i)) == i + 1);
+    CHECK(join_table_assign(&table, test_eui(JOIN_TABLE_LAST_NODE)) == 0);
+    CHECK(join_table_lookup(&table, test_eui(JOIN_TABLE_LAST_NODE)) == 0);
+
+    // Every node can still be found both ways, and a leaf that joins
+    // again gets its old number
+    bool found = true;
+    for (uint16_t i = 0; i < JOIN_TABLE_LAST_NODE; ++i) {
+        found = found && join_table_lookup(&table, test_eui(i)) == i + 1;
+        found = found && join_table_eui(&table, (uint8_t)(i + 1)) == test_eui(i);
+    }
+    CHECK(found);
+    CHECK(join_table_assign(&table, test_eui(100)) == 101);
+    CHECK(join_table_eui(&table, 0) == 0 && join_table_eui(&table, 255) == 0);
+}
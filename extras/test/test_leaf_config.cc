@@ -0,0 +1,56 @@
+// Tests for the leaf node's settings and the config message.
+
+#include "test.h"
+
+#include "leaf_config.h"
+#include "data_batch.h"
+
+void test_leaf_config() {
+    leaf_config_t cfg;
+    init_leaf_config(&cfg);
+    CHECK(cfg.interval == LEAF_DEFAULT_INTERVAL && cfg.spreading_factor == LEAF_DEFAULT_SF);
+    CHECK(cfg.tx_power == LEAF_DEFAULT_TX_POWER && cfg.batch_depth == 1);
+
+    config_t c;
+    build_config(&c, 5, 300, 12, 20, DATA_BATCH_MAX_READINGS);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5)
+          == (CONFIG_CHANGED_INTERVAL | CONFIG_CHANGED_SF | CONFIG_CHANGED_TX_POWER | CONFIG_CHANGED_BATCH_DEPTH));
+    CHECK(cfg.interval == 300 && cfg.spreading_factor == 12 && cfg.tx_power == 20
+          && cfg.batch_depth == DATA_BATCH_MAX_READINGS);
+
+    // The same message again changes nothing
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5) == 0);
+
+    // For another node, or truncated
+    build_config(&c, 6, 900, 7, 2, 1);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5) == 0 && cfg.interval == 300);
+    build_config(&c, 5, 900, 7, 2, 1);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE - 1, 5) == 0 && cfg.interval == 300);
+
+    // Zero and out of range values are left alone, each on its own
+    build_config(&c, 5, LEAF_MIN_INTERVAL - 1, 13, LEAF_MAX_TX_POWER + 1, DATA_BATCH_MAX_READINGS + 1);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5) == 0);
+    build_config(&c, 5, 0, 6, LEAF_MIN_TX_POWER - 1, 0);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5) == 0);
+    build_config(&c, 5, 0, 0, -128, 0);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5) == 0);
+    build_config(&c, 5, 0, 7, 0, 0);
+    CHECK(apply_config_message(&cfg, &c, CONFIG_SIZE, 5) == CONFIG_CHANGED_SF && cfg.spreading_factor == 7);
+    CHECK(cfg.interval == 300 && cfg.tx_power == 20 && cfg.batch_depth == DATA_BATCH_MAX_READINGS);
+
+    // With a CRC trailer, and through a view
+    uint8_t buf[CONFIG_SIZE + MESSAGE_CRC_SIZE];
+    build_config(&c, 5, LEAF_MIN_INTERVAL, 0, LEAF_MIN_TX_POWER, 1);
+    memcpy(buf, &c, CONFIG_SIZE);
+    size_t n = add_message_crc(buf, CONFIG_SIZE, sizeof(buf));
+    buf[3] ^= 1;
+    CHECK(apply_config_message(&cfg, (const config_t *)buf, (uint8_t)n, 5) == 0);
+    buf[3] ^= 1;
+    CHECK(apply_config_message(&cfg, (const config_t *)buf, (uint8_t)n, 5)
+          == (CONFIG_CHANGED_INTERVAL | CONFIG_CHANGED_TX_POWER | CONFIG_CHANGED_BATCH_DEPTH));
+
+    build_config(&c, 5, 3600, 0, 0, 0);
+    CHECK(apply_config_message(&cfg, config_view((const uint8_t *)&c, CONFIG_SIZE), 5) == CONFIG_CHANGED_INTERVAL);
+    CHECK(apply_config_message(&cfg, config_view((const uint8_t *)&c, CONFIG_SIZE - 1), 5) == 0);
+    CHECK(cfg.interval == 3600);
+}
@@ -0,0 +1,62 @@
+// Tests for the main node's per-node reading cache.
+
+#include "test.h"
+
+#include "reading_cache.h"
+
+static void add_reading(reading_cache_t *cache, uint8_t node, uint32_t time, int16_t temp, uint16_t moisture) {
+    packet_t data;
+    build_data_packet(&data, node, time, time, 330, 0, temp, 5000, 0);
+    add_cached_reading(cache, &data, moisture);
+}
+
+void test_reading_cache() {
+    static reading_cache_t cache;
+    reading_summary_t s;
+    cached_reading_t r;
+
+    // Whatever was in memory before init_reading_cache() is never read
+    memset(&cache, 0xa5, sizeof(cache));
+    init_reading_cache(&cache);
+    CHECK(get_cached_count(&cache, 1) == 0 && !get_cached_summary(&cache, 1, cache_temp, &s));
+    CHECK(!get_cached_reading(&cache, 1, 0, &r));
+
+    add_reading(&cache, 1, 100, -250, 3000);
+    CHECK(get_cached_summary(&cache, 1, cache_temp, &s) && s.count == 1);
+    CHECK(s.min == -250 && s.max == -250 && s.mean == -250);
+    add_reading(&cache, 1, 200, 150, 1000);
+    CHECK(get_cached_summary(&cache, 1, cache_temp, &s) && s.min == -250 && s.max == 150 && s.mean == -50);
+    CHECK(get_cached_summary(&cache, 1, cache_moisture, &s) && s.min == 1000 && s.max == 3000 && s.mean == 2000);
+    CHECK(get_cached_reading(&cache, 1, 1, &r) && r.time == 100 && r.temp == -250 && r.moisture == 3000);
+    CHECK(get_cached_reading(&cache, 1, 0, &r) && r.time == 200 && r.battery == 330 && r.humidity == 5000);
+    CHECK(!get_cached_reading(&cache, 1, 2, &r));
+
+    // Fill the ring and wrap; the extremes fall out and are found again
+    for (uint32_t t = 3; t <= READING_CACHE_DEPTH + 2; ++t)
+        add_reading(&cache, 1, t * 100, (int16_t)t, 2000);
+    CHECK(get_cached_count(&cache, 1) == READING_CACHE_DEPTH);
+    CHECK(get_cached_summary(&cache, 1, cache_temp, &s) && s.count == READING_CACHE_DEPTH);
+    CHECK(s.min == 3 && s.max == READING_CACHE_DEPTH + 2);
+    CHECK(get_cached_summary(&cache, 1, cache_moisture, &s) && s.min == 2000 && s.max == 2000 && s.mean == 2000);
+
+    int32_t sum = 0;
+    for (uint32_t t = 3; t <= READING_CACHE_DEPTH + 2; ++t)
+        sum += (int32_t)t;
+    CHECK(get_cached_summary(&cache, 1, cache_temp, &s) && s.mean == sum / READING_CACHE_DEPTH);
+    CHECK(get_cached_reading(&cache, 1, READING_CACHE_DEPTH - 1, &r) && r.time == 300);
+    CHECK(get_cached_reading(&cache, 1, 0, &r) && r.time == (READING_CACHE_DEPTH + 2) * 100);
+
+    // Nodes past READING_CACHE_NODES get no ring
+    packet_t data;
+    uint8_t cached = 0;
+    for (uint8_t node = 2; node <= READING_CACHE_NODES + 1; ++node) {
+        build_data_packet(&data, node, 1, 1, 330, 0, 0, 0, 0);
+        cached += add_cached_reading(&cache, &data);
+    }
+    CHECK(cached == READING_CACHE_NODES - 1 && cache.used == READING_CACHE_NODES);
+    CHECK(get_cached_count(&cache, READING_CACHE_NODES) == 1 && get_cached_count(&cache, READING_CACHE_NODES + 1) == 0);
+    CHECK(get_cached_count(&cache, 1) == READING_CACHE_DEPTH);
+
+    init_reading_cache(&cache);
+    CHECK(get_cached_count(&cache, 1) == 0 && cache.used == 0);
+}
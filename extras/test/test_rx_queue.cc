@@ -0,0 +1,59 @@
+// Tests for the receive queue.
+
+#include "test.h"
+
+#include "rx_queue.h"
+
+void test_rx_queue() {
+    static rx_queue_t q;
+    init_rx_queue(&q);
+
+    uint8_t m[3] = {0, 2, 3};
+    uint8_t len;
+    CHECK(rx_queue_count(&q) == 0 && !rx_queue_front(&q, &len));
+
+    // Run the indices round their uint8_t range several times
+    uint16_t order_errors = 0;
+    for (int round = 0; round < 100; ++round) {
+        for (uint8_t i = 0; i < RX_QUEUE_SLOTS; ++i) {
+            uint8_t *slot = rx_queue_reserve(&q);
+            if (!slot) {
+                order_errors++;
+                continue;
+            }
+            m[0] = i;
+            memcpy(slot, m, sizeof(m));
+            rx_queue_commit(&q, sizeof(m));
+        }
+        order_errors += rx_queue_count(&q) != RX_QUEUE_SLOTS;
+
+        for (uint8_t i = 0; i < RX_QUEUE_SLOTS; ++i) {
+            const uint8_t *b = rx_queue_front(&q, &len);
+            if (!b || len != sizeof(m) || b[0] != i)
+                order_errors++;
+            rx_queue_pop(&q);
+        }
+        order_errors += rx_queue_front(&q, &len) != 0;
+    }
+    CHECK(order_errors == 0);
+
+    // Polling a full queue loses nothing and counts nothing
+    for (uint8_t i = 0; i < RX_QUEUE_SLOTS; ++i)
+        CHECK(rx_queue_push(&q, m, sizeof(m)));
+    int reserved = 0;
+    for (int i = 0; i < 1000; ++i)
+        reserved += rx_queue_reserve(&q) != 0;
+    CHECK(reserved == 0);
+    CHECK(q.dropped == 0 && rx_queue_count(&q) == RX_QUEUE_SLOTS);
+
+    // A message thrown away is counted once
+    CHECK(!rx_queue_push(&q, m, sizeof(m)));
+    CHECK(q.dropped == 1);
+    rx_queue_drop(&q);
+    CHECK(q.dropped == 2);
+
+    // A freed slot is used again; a message that is too long is dropped
+    rx_queue_pop(&q);
+    CHECK(!rx_queue_push(&q, m, RH_RF95_MAX_MESSAGE_LEN + 1) && q.dropped == 3);
+    CHECK(rx_queue_push(&q, m, RH_RF95_MAX_MESSAGE_LEN) && rx_queue_count(&q) == RX_QUEUE_SLOTS);
+}
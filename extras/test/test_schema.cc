@@ -0,0 +1,59 @@
+// Tests that the schema-generated codecs match the message structs.
+
+#include "test.h"
+
+#include "messages.h"
+#include "data_packet.h"
+#include "message_schema.h"
+
+void test_schema_codecs() {
+    // build_data_packet() writes the same bytes as filling in the struct
+    packet_t built, filled;
+    memset(&filled, 0, sizeof(filled));
+    filled.type = data_packet;
+    filled.node = 0xfe;
+    filled.message = 0x89abcdef;
+    filled.time = 1615680000;
+    filled.battery = 395;
+    filled.last_tx_duration = 0xffff;
+    filled.temp = -32768;
+    filled.humidity = 6250;
+    filled.status = 0x81;
+    build_data_packet(&built, 0xfe, 0x89abcdef, 1615680000, 395, 0xffff, -32768, 6250, 0x81);
+    CHECK(memcmp(&built, &filled, sizeof(packet_t)) == 0);
+
+    // The scaled CSV line at the limits of each field
+    char csv[DATA_PACKET_CSV_LEN];
+    build_data_packet(&built, 255, 0xffffffff, 0xffffffff, 0xffff, 0xffff, -32768, 0xffff, 0xff);
+    size_t n = data_packet_to_csv(&built, csv, sizeof(csv), true);
+    CHECK(strcmp(csv, "255, 4294967295, 4294967295, 655.35, 65535, -327.68, 655.35, 0xff") == 0);
+    CHECK(n == strlen(csv));
+
+    // Text messages
+    text_t t;
+    const char *hello = "hello, world";
+    build_text_message(&t, 3, (uint8_t)strlen(hello), (const uint8_t *)hello);
+    CHECK(get_message_type(&t) == text && t.node == 3 && t.length == strlen(hello));
+
+    uint8_t node, length;
+    uint8_t chars[TEXT_BUF_LEN];
+    const uint8_t text_len = (uint8_t)(offsetof(text_t, buf) + strlen(hello));
+    CHECK(parse_text_message(&t, text_len, &node, &length, chars));
+    CHECK(node == 3 && length == strlen(hello) && memcmp(chars, hello, length) == 0);
+    CHECK(!parse_text_message(&t, text_len - 1, &node, &length, chars));
+
+    char s[64], expected[64];
+    snprintf(expected, sizeof(expected), "%u, %s", 3, hello);
+    CHECK(text_message_to_string(&t, s, sizeof(s)) == strlen(expected) && strcmp(s, expected) == 0);
+    // Cut short, the start of the same string
+    CHECK(text_message_to_string(&t, s, 6) == 5 && strcmp(s, "3, he") == 0);
+    CHECK(text_message_to_string(&t, s, 2) == 1 && strcmp(s, "3") == 0);
+    CHECK(text_message_to_string(&t, s, 0) == 0);
+
+    // Text longer than a frame is cut to fit
+    static uint8_t long_text[255];
+    memset(long_text, 'x', sizeof(long_text));
+    build_text_message(&t, 3, sizeof(long_text), long_text);
+    CHECK(t.length == TEXT_BUF_LEN);
+    CHECK(parse_text_message(&t, TEXT_SIZE, &node, &length, chars) && length == TEXT_BUF_LEN);
+}
@@ -0,0 +1,91 @@
+// Tests for the sector-aligned writer.
+
+#include "test.h"
+
+#include "sector_writer.h"
+
+struct test_file_t {
+    uint8_t data[4 * SECTOR_SIZE];
+    size_t size;
+    int writes;
+    int unaligned;      // writes that did not end on a sector boundary
+    int fail_after;     // fail every write once this many have been made; -1 never
+};
+
+static bool write_to_file(const uint8_t *buf, size_t len, void *context) {
+    test_file_t *f = (test_file_t *)context;
+    if (f->fail_after >= 0 && f->writes >= f->fail_after)
+        return false;
+    if (f->size + len > sizeof(f->data))
+        return false;
+
+    memcpy(f->data + f->size, buf, len);
+    f->size += len;
+    f->writes++;
+    if (f->size % SECTOR_SIZE)
+        f->unaligned++;
+    return true;
+}
+
+static void init_test_file(test_file_t *f, size_t size) {
+    memset(f, 0, sizeof(test_file_t));
+    f->size = size;
+    f->fail_after = -1;
+}
+
+void test_sector_writer() {
+    static uint8_t data[3 * SECTOR_SIZE];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 13 + 5);
+
+    // Small records only ever reach the file in whole sectors
+    static test_file_t f;
+    init_test_file(&f, 0);
+    sector_writer_t w;
+    init_sector_writer(&w, write_to_file, &f);
+    for (size_t i = 0; i + 20 <= sizeof(data); i += 20)
+        CHECK(sector_writer_write(&w, data + i, 20) == 20);
+    CHECK(f.size == 2 * SECTOR_SIZE && f.unaligned == 0);
+    CHECK(sector_writer_flush(&w));
+    CHECK(f.size == sizeof(data) - sizeof(data) % 20);
+    CHECK(memcmp(f.data, data, f.size) == 0);
+
+    // After a partial flush the next write realigns the file
+    const size_t flushed = f.size;
+    CHECK(sector_writer_write(&w, data, SECTOR_SIZE) == SECTOR_SIZE);
+    CHECK(f.size == (flushed / SECTOR_SIZE + 1) * SECTOR_SIZE);
+    CHECK(memcmp(f.data + flushed, data, f.size - flushed) == 0);
+
+    // Appending to a file that does not end on a sector boundary
+    init_test_file(&f, 100);
+    init_sector_writer(&w, write_to_file, &f, 100);
+    CHECK(sector_writer_write(&w, data, 2 * SECTOR_SIZE) == 2 * SECTOR_SIZE);
+    CHECK(f.size == 2 * SECTOR_SIZE && f.unaligned == 0 && f.writes == 2);
+    CHECK(memcmp(f.data + 100, data, f.size - 100) == 0);
+
+    // A failing sink: nothing is lost, and a retry from the bytes not
+    // consumed completes the file
+    init_test_file(&f, 0);
+    f.fail_after = 1;
+    init_sector_writer(&w, write_to_file, &f);
+    CHECK(sector_writer_write(&w, data, 10) == 10);
+    size_t consumed = sector_writer_write(&w, data + 10, sizeof(data) - 10);
+    CHECK(consumed == SECTOR_SIZE - 10);
+    CHECK(f.writes == 1 && f.size == SECTOR_SIZE);
+    f.fail_after = -1;
+    consumed += 10;
+    while (consumed < sizeof(data))
+        consumed += sector_writer_write(&w, data + consumed, sizeof(data) - consumed);
+    CHECK(sector_writer_flush(&w));
+    CHECK(f.size == sizeof(data) && memcmp(f.data, data, sizeof(data)) == 0);
+    CHECK(f.unaligned == 0);
+
+    // A failed flush keeps the buffered bytes for the next one
+    init_test_file(&f, 0);
+    f.fail_after = 0;
+    init_sector_writer(&w, write_to_file, &f);
+    CHECK(sector_writer_write(&w, data, 10) == 10);
+    CHECK(!sector_writer_flush(&w) && f.size == 0);
+    f.fail_after = -1;
+    CHECK(sector_writer_flush(&w) && f.size == 10 && memcmp(f.data, data, 10) == 0);
+}
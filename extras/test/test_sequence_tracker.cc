@@ -0,0 +1,65 @@
+// Tests for duplicate and loss detection.
+
+#include "test.h"
+
+#include "sequence_tracker.h"
+
+/// Leaves send a reading every ten minutes
+#define T(message) (1615680000u + 600u * (message))
+
+void test_sequence_tracker() {
+    static sequence_tracker_t t;
+    init_sequence_tracker(&t);
+
+    CHECK(get_node_sequence(&t, 5)->received == 0);
+    CHECK(track_sequence(&t, 5, 10, T(10)) == sequence_new);
+    CHECK(track_sequence(&t, 5, 10, T(10)) == sequence_duplicate);
+    CHECK(track_sequence(&t, 5, 13, T(13)) == sequence_new);
+    CHECK(get_node_sequence(&t, 5)->lost == 2);
+    CHECK(track_sequence(&t, 5, 11, T(11)) == sequence_late);
+    CHECK(track_sequence(&t, 5, 11, T(11)) == sequence_duplicate);
+    CHECK(get_node_sequence(&t, 5)->lost == 1 && get_node_sequence(&t, 5)->duplicates == 2);
+
+    // The edge of the window, then beyond it
+    CHECK(track_sequence(&t, 5, 100, T(100)) == sequence_new);
+    CHECK(track_sequence(&t, 5, 100 - (SEQUENCE_WINDOW - 1), T(100 - (SEQUENCE_WINDOW - 1))) == sequence_late);
+    CHECK(track_sequence(&t, 5, 100 - SEQUENCE_WINDOW, T(100 - SEQUENCE_WINDOW)) == sequence_restart);
+    CHECK(track_sequence(&t, 5, 100 - SEQUENCE_WINDOW + 1, T(100 - SEQUENCE_WINDOW + 1)) == sequence_new);
+
+    // Message numbers wrap
+    init_sequence_tracker(&t);
+    CHECK(track_sequence(&t, 1, 0xfffffffe, T(0)) == sequence_new);
+    CHECK(track_sequence(&t, 1, 1, T(3)) == sequence_new);
+    CHECK(get_node_sequence(&t, 1)->lost == 2);
+    CHECK(track_sequence(&t, 1, 0xffffffff, T(1)) == sequence_late);
+    CHECK(track_sequence(&t, 1, 0xfffffffe, T(0)) == sequence_duplicate);
+
+    // A reset inside the window; message 0 before the leaf has set its clock
+    init_sequence_tracker(&t);
+    CHECK(track_sequence(&t, 5, 20, T(20)) == sequence_new);
+    CHECK(track_sequence(&t, 5, 0, 0) == sequence_restart);
+    CHECK(track_sequence(&t, 5, 1, T(21)) == sequence_new);
+    CHECK(track_sequence(&t, 5, 0, 0) == sequence_duplicate);
+
+    // Two resets close together: every reading after each reset is new
+    init_sequence_tracker(&t);
+    uint32_t time = T(0);
+    for (uint32_t m = 0; m < 5; ++m)
+        CHECK(track_sequence(&t, 7, m, time += 600) == sequence_new);
+    CHECK(track_sequence(&t, 7, 0, time += 600) == sequence_restart);
+    for (uint32_t m = 1; m < 3; ++m)
+        CHECK(track_sequence(&t, 7, m, time += 600) == sequence_new);
+    CHECK(track_sequence(&t, 7, 0, time += 600) == sequence_restart);
+    CHECK(track_sequence(&t, 7, 1, time += 600) == sequence_new);
+    // ... a retransmission of the last one is still a duplicate
+    CHECK(track_sequence(&t, 7, 1, time) == sequence_duplicate);
+    CHECK(track_sequence(&t, 7, 0, time - 600) == sequence_duplicate);
+    CHECK(get_node_sequence(&t, 7)->lost == 0 && get_node_sequence(&t, 7)->received == 10);
+
+    // A saturated loss count stays put
+    CHECK(track_sequence(&t, 6, 0, T(0)) == sequence_new);
+    CHECK(track_sequence(&t, 6, 100000, T(100000)) == sequence_new);
+    CHECK(get_node_sequence(&t, 6)->lost == 0xffff);
+    CHECK(track_sequence(&t, 6, 99990, T(99990)) == sequence_late);
+    CHECK(get_node_sequence(&t, 6)->lost == 0xffff);
+}
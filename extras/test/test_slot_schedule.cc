@@ -0,0 +1,36 @@
+// Tests for the TDMA transmit schedule.
+
+#include "test.h"
+
+#include "slot_schedule.h"
+
+void test_slot_schedule() {
+    tx_slot_t slot;
+    CHECK(!make_tx_slot(&slot, 1, 0, 600) && get_slot_count(&slot) == 0);
+    CHECK(!make_tx_slot(&slot, 1, 20, 10) && get_slot_count(&slot) == 0);
+    CHECK(next_slot_time(&slot, 1615680007) == 1615680007);
+
+    // 30 slots of 20 s; node n gets slot n - 1, wrapping when there are
+    // more nodes than slots
+    CHECK(make_tx_slot(&slot, 1, 20, 600) && get_slot_count(&slot) == 30 && slot.slot == 0);
+    CHECK(make_tx_slot(&slot, 30, 20, 600) && slot.slot == 29);
+    CHECK(make_tx_slot(&slot, 31, 20, 600) && slot.slot == 0);
+    CHECK(make_tx_slot(&slot, 254, 20, 600) && slot.slot == 253 % 30);
+
+    // 1615680000 is a multiple of 600, so a frame starts there
+    const uint32_t frame = 1615680000;
+    make_tx_slot(&slot, 4, 20, 600);
+    CHECK(next_slot_time(&slot, frame) == frame + 60);
+    CHECK(next_slot_time(&slot, frame + 60) == frame + 60);
+    CHECK(next_slot_time(&slot, frame + 61) == frame + 600 + 60);
+    CHECK(next_slot_time(&slot, frame + 599) == frame + 600 + 60);
+
+    // A frame of more than 256 slots is capped
+    CHECK(make_tx_slot(&slot, 1, 1, 3600) && get_slot_count(&slot) == 256);
+
+    // A slot that does not fit in the frame, e.g., from a bad response
+    slot.slot = 40;
+    slot.slot_length = 20;
+    slot.frame_length = 600;
+    CHECK(next_slot_time(&slot, frame + 7) == frame + 7);
+}
@@ -0,0 +1,89 @@
+// Tests for the leaf node's store-and-forward queue.
+
+#include "test.h"
+
+#include "store_forward.h"
+
+#define TEST_SPILL_RECORDS 50
+
+struct test_spill_t {
+    uint8_t data[TEST_SPILL_RECORDS * DATA_PACKET_SIZE];
+    uint32_t bad_address;   // reads of this packet fail; ~0 for none
+};
+
+static bool spill_read(uint32_t address, void *buf, size_t len, void *context) {
+    test_spill_t *s = (test_spill_t *)context;
+    if (address == s->bad_address)
+        return false;
+    memcpy(buf, s->data + address, len);
+    return true;
+}
+
+static bool spill_write(uint32_t address, const void *buf, size_t len, void *context) {
+    test_spill_t *s = (test_spill_t *)context;
+    memcpy(s->data + address, buf, len);
+    return true;
+}
+
+static void push_packets(sf_queue_t *q, uint32_t first, uint32_t count) {
+    for (uint32_t i = first; i < first + count; ++i) {
+        packet_t p;
+        build_data_packet(&p, 3, i, 1615680000 + 600 * i, 395, 1000, -420, 6250, 0);
+        sf_queue_push(q, &p);
+    }
+}
+
+/**
+ * @brief Send and release batches until the queue is empty
+ * @return The number of packets delivered, or ~0 if they were out of order
+ */
+static uint32_t drain(sf_queue_t *q, uint32_t *next) {
+    uint32_t delivered = 0;
+    data_batch_t batch;
+    uint8_t n;
+    while ((n = sf_queue_fill_batch(q, &batch))) {
+        if (batch.message < *next)
+            return ~0u;
+        *next = batch.message + n;
+        delivered += n;
+        sf_queue_release(q, n);
+    }
+    return delivered;
+}
+
+void test_store_forward() {
+    static test_spill_t spill;
+    spill.bad_address = ~0u;
+    const storage_t storage = {spill_read, spill_write, &spill};
+
+    // RAM only: the oldest packets are dropped
+    static sf_queue_t q;
+    init_sf_queue(&q);
+    push_packets(&q, 0, 20);
+    CHECK(sf_queue_count(&q) == SF_RAM_RECORDS && q.dropped == 20 - SF_RAM_RECORDS);
+    packet_t p;
+    CHECK(sf_queue_peek(&q, 0, &p) && p.message == 20 - SF_RAM_RECORDS);
+    CHECK(!sf_queue_peek(&q, SF_RAM_RECORDS, &p));
+
+    // Both full, with the spill area wrapping
+    init_sf_queue(&q, &storage, 0, TEST_SPILL_RECORDS);
+    push_packets(&q, 0, 80);
+    const uint32_t kept = SF_RAM_RECORDS + TEST_SPILL_RECORDS;
+    CHECK(sf_queue_count(&q) == kept && q.dropped == 80 - kept);
+    uint32_t next = 80 - kept;
+    CHECK(drain(&q, &next) == kept && next == 80);
+    CHECK(sf_queue_count(&q) == 0 && q.unreadable == 0);
+
+    // An unreadable spilled packet is skipped, not retried for ever
+    init_sf_queue(&q, &storage, 0, TEST_SPILL_RECORDS);
+    push_packets(&q, 0, 40);
+    spill.bad_address = 5 * DATA_PACKET_SIZE;
+    next = 0;
+    CHECK(drain(&q, &next) == 39 && next == 40);
+    CHECK(q.unreadable == 1 && sf_queue_count(&q) == 0);
+    spill.bad_address = ~0u;
+
+    // An empty queue
+    data_batch_t batch;
+    CHECK(sf_queue_fill_batch(&q, &batch) == 0);
+}
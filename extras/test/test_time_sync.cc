@@ -0,0 +1,53 @@
+// Tests for leaf node clock drift compensation.
+
+#include "test.h"
+
+#include "time_sync.h"
+
+/**
+ * @brief Feed hourly samples from an RTC that runs slow by ppm
+ * @return The RTC time of the last sample
+ */
+static uint32_t feed_hours(time_sync_t *ts, uint32_t local0, uint32_t time0, int32_t ppm, uint32_t hours) {
+    uint32_t local = local0;
+    for (uint32_t h = 0; h <= hours; ++h) {
+        uint32_t elapsed = h * 3600;
+        local = local0 + (uint32_t)(elapsed - (int64_t)elapsed * ppm / 1000000);
+        time_sync_update(ts, local, time0 + elapsed);
+    }
+    return local;
+}
+
+void test_time_sync() {
+    time_sync_t ts;
+    init_time_sync(&ts);
+    CHECK(time_sync_now(&ts, 1234) == 1234);
+    CHECK(time_sync_due(&ts, 1234, 10));
+
+    // After a day of samples the drift is known to within error_ppm
+    const uint32_t time0 = 1615680000;
+    uint32_t local = feed_hours(&ts, 1000, time0, 50, 24);
+    CHECK(ts.drift_ppm >= 50 - ts.error_ppm && ts.drift_ppm <= 50 + ts.error_ppm);
+    CHECK(ts.error_ppm <= 1000000 / (24 * 3600) + TIME_SYNC_MIN_ERROR_PPM);
+    CHECK(time_sync_now(&ts, local) == time0 + 24 * 3600);
+
+    // A day without a sample: the prediction is within the stated error
+    uint32_t later = local + 86400 - 86400 * 50 / 1000000;
+    uint32_t predicted = time_sync_now(&ts, later);
+    uint32_t actual = time0 + 2 * 86400;
+    uint32_t off = (predicted > actual) ? predicted - actual : actual - predicted;
+    CHECK(off <= time_sync_error(&ts, later));
+    CHECK(!time_sync_due(&ts, later, 10) && time_sync_due(&ts, later + 100 * 86400, 10));
+
+    // The RTC counter wraps
+    init_time_sync(&ts);
+    local = feed_hours(&ts, 0xffffffff - 12 * 3600, time0, -30, 24);
+    CHECK(local < 0x10000000 && ts.drift_ppm >= -30 - ts.error_ppm && ts.drift_ppm <= -30 + ts.error_ppm);
+
+    // A clock reset shows up as an impossible drift and starts over
+    init_time_sync(&ts);
+    local = feed_hours(&ts, 1000, time0, 0, 2);
+    time_sync_update(&ts, local + 3600, time0 + 86400);
+    CHECK(ts.samples == 1 && ts.drift_ppm == 0 && ts.first_local == local + 3600);
+    CHECK(time_sync_now(&ts, local + 3600) == time0 + 86400);
+}
@@ -0,0 +1,48 @@
+// Tests for section timing and the timing report.
+
+#include "test.h"
+
+#include "timing.h"
+
+void test_timing() {
+    static timing_t t;
+    init_timing(&t);
+
+    timing_report_t r;
+    build_timing_report(&r, 4, &t);
+    CHECK(r.sections[timing_tx].count == 0 && r.sections[timing_tx].min == 0 && r.sections[timing_tx].mean == 0);
+
+    timing_record(&t, timing_tx, 5);
+    timing_record(&t, timing_tx, 900000);
+    timing_record(&t, timing_tx, 5);
+    CHECK(timing_mean(&t.sections[timing_tx]) == 300003);
+    timing_record(&t, (TimingSection)TIMING_SECTIONS, 1);
+
+    // SF12 sends of about 1.5 s run the total past 2^32 us; the mean
+    // must stay right
+    init_timing(&t);
+    const uint32_t sends = 70000;
+    for (uint32_t i = 0; i < sends; ++i)
+        timing_record(&t, timing_tx, (i & 1) ? 1400000 : 1600000);
+    CHECK(t.sections[timing_tx].total > 0xffffffffull);
+    CHECK(timing_mean(&t.sections[timing_tx]) == 1500000);
+    CHECK(t.sections[timing_tx].min == 1400000 && t.sections[timing_tx].max == 1600000);
+
+    build_timing_report(&r, 4, &t);
+    timing_report_entry_t sections[TIMING_SECTIONS];
+    uint8_t node;
+    CHECK(parse_timing_report(&r, TIMING_REPORT_SIZE, &node, sections));
+    CHECK(node == 4 && sections[timing_tx].count == 0xffff && sections[timing_tx].mean == 1500000);
+    CHECK(!parse_timing_report(&r, TIMING_REPORT_SIZE - 1, &node, sections));
+
+    // A short buffer gets the start of the full string
+    char full[400], cut[400];
+    size_t n = timing_report_to_string(&r, full, sizeof(full), true);
+    CHECK(n == strlen(full));
+    bool prefix = true;
+    for (size_t len = 1; len < n + 3; ++len) {
+        size_t k = timing_report_to_string(&r, cut, len, true);
+        prefix = prefix && k == ((len - 1 < n) ? len - 1 : n) && strlen(cut) == k && strncmp(cut, full, k) == 0;
+    }
+    CHECK(prefix);
+}
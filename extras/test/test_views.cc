@@ -0,0 +1,55 @@
+// Tests for the read-only message views.
+
+#include "test.h"
+
+#include "messages.h"
+#include "data_packet.h"
+#include "data_batch.h"
+#include "message_views.h"
+
+void test_message_views() {
+    packet_t p;
+    build_data_packet(&p, 17, 0xfffffffe, 1615680000, 395, 1000, -420, 6250, 0xab);
+    p.data = 9;
+
+    const uint8_t *buf = (const uint8_t *)&p;
+    data_packet_view v(buf, DATA_PACKET_SIZE);
+    CHECK(v.valid());
+    CHECK(v.node() == 17 && v.message() == 0xfffffffe && v.time() == 1615680000);
+    CHECK(v.battery() == 395 && v.last_tx_duration() == 1000 && v.temp() == -420);
+    CHECK(v.humidity() == 6250 && v.status() == 0xab && v.data() == 9);
+
+    // Too short, or the wrong type
+    CHECK(!data_packet_view(buf, DATA_PACKET_SIZE - 1).valid());
+    CHECK(!data_packet_view(buf, 0).valid());
+    CHECK(!time_response_view(buf, DATA_PACKET_SIZE).valid());
+
+    time_response_t tr;
+    tx_slot_t slot = {3, 14, 600};
+    build_time_response(&tr, 5, 1615680000, &slot);
+    time_response_view tv((const uint8_t *)&tr, TIME_RESPONSE_SIZE);
+    CHECK(tv.valid());
+    CHECK(tv.node() == 5 && tv.time() == 1615680000);
+    CHECK(tv.slot() == 3 && tv.slot_length() == 14 && tv.frame_length() == 600);
+
+    // A text message must hold the length it claims
+    text_t t;
+    build_text_message(&t, 3, 5, (const uint8_t *)"hello");
+    const uint8_t text_len = (uint8_t)(TEXT_SIZE - TEXT_BUF_LEN + 5);
+    text_view xv((const uint8_t *)&t, text_len);
+    CHECK(xv.valid() && xv.node() == 3 && xv.length() == 5 && memcmp(xv.text(), "hello", 5) == 0);
+    CHECK(!text_view((const uint8_t *)&t, text_len - 1).valid());
+
+    // A batch must hold every reading it claims
+    data_batch_t batch;
+    build_data_batch(&batch, 17);
+    for (uint8_t i = 0; i < 3; ++i) {
+        build_data_packet(&p, 17, 100 + i, 1615680000 + 600 * i, 395, 1000, (int16_t)(-420 + i), 6250, i);
+        CHECK(add_data_batch_reading(&batch, &p));
+    }
+    const uint8_t batch_len = (uint8_t)(DATA_BATCH_HEADER_SIZE + 3 * sizeof(batch_reading_t));
+    data_batch_view bv((const uint8_t *)&batch, batch_len);
+    CHECK(bv.valid() && bv.node() == 17 && bv.count() == 3);
+    CHECK(bv.message(2) == 102 && bv.time(2) == 1615680000 + 1200 && bv.temp(2) == -418 && bv.status(2) == 2);
+    CHECK(!data_batch_view((const uint8_t *)&batch, batch_len - 1).valid());
+}
@@ -0,0 +1,78 @@
+// snprintf-free integer formatting.
+
+#include <Arduino.h>
+
+#include "fast_format.h"
+
+/**
+ * @brief Write an unsigned value in decimal
+ * @param p Destination
+ * @param value The value
+ * @return Pointer to the character after the last digit
+ */
+char *format_uint(char *p, uint32_t value) {
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    while (n)
+        *p++ = digits[--n];
+
+    return p;
+}
+
+/**
+ * @brief Write a signed value in decimal
+ * @param p Destination
+ * @param value The value
+ * @return Pointer to the character after the last digit
+ */
+char *format_int(char *p, int32_t value) {
+    if (value < 0) {
+        *p++ = '-';
+        return format_uint(p, 0u - (uint32_t)value);
+    }
+
+    return format_uint(p, (uint32_t)value);
+}
+
+/**
+ * @brief Write a value held as hundredths with two decimal places
+ * For example, a temperature of -425 is written as '-4.25'.
+ * @param p Destination
+ * @param value The value * 100
+ * @return Pointer to the character after the last digit
+ */
+char *format_fixed100(char *p, int32_t value) {
+    uint32_t v = (uint32_t)value;
+    if (value < 0) {
+        *p++ = '-';
+        v = 0u - v;
+    }
+
+    p = format_uint(p, v / 100);
+    *p++ = '.';
+    *p++ = (char)('0' + (v % 100) / 10);
+    *p++ = (char)('0' + v % 10);
+
+    return p;
+}
+
+/**
+ * @brief Write a byte as '0x' and two lower case hex digits
+ * @param p Destination
+ * @param value The value
+ * @return Pointer to the character after the last digit
+ */
+char *format_hex_byte(char *p, uint8_t value) {
+    static const char hex[] = "0123456789abcdef";
+    *p++ = '0';
+    *p++ = 'x';
+    *p++ = hex[value >> 4];
+    *p++ = hex[value & 0x0f];
+
+    return p;
+}
@@ -0,0 +1,27 @@
+/**
+ * Integer to decimal formatting without snprintf(). Each function
+ * writes its digits at p, without a null, and returns a pointer to the
+ * character after the last one written. The caller makes sure there is
+ * room; see the *_MAX_LEN values.
+ */
+
+#ifndef h_fast_format_h
+#define h_fast_format_h
+
+#include <Arduino.h>
+
+/// The most characters format_uint() or format_int() write
+#define FORMAT_INT_MAX_LEN 11
+
+/// The most characters format_fixed100() writes
+#define FORMAT_FIXED100_MAX_LEN 12
+
+/// The characters format_hex_byte() writes
+#define FORMAT_HEX_BYTE_LEN 4
+
+char *format_uint(char *p, uint32_t value);
+char *format_int(char *p, int32_t value);
+char *format_fixed100(char *p, int32_t value);
+char *format_hex_byte(char *p, uint8_t value);
+
+#endif
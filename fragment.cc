@@ -0,0 +1,192 @@
+// Fragmentation and reassembly of large transfers.
+
+#include <Arduino.h>
+
+#include "fragment.h"
+#include "message_schema.h"
+
+/**
+ * @brief How many fragments a transfer takes
+ * @param length The number of bytes to send
+ * @return The number of fragments, or 0 if length is more than
+ * FRAGMENT_MAX_TRANSFER. An empty transfer is one empty fragment.
+ */
+uint8_t get_fragment_count(uint16_t length) {
+    if (length > FRAGMENT_MAX_TRANSFER)
+        return 0;
+    if (length == 0)
+        return 1;
+
+    return (uint8_t)((length + FRAGMENT_PAYLOAD_SIZE - 1) / FRAGMENT_PAYLOAD_SIZE);
+}
+
+/**
+ * @brief Build one fragment of a transfer
+ * @param buf Destination, at least RH_RF95_MAX_MESSAGE_LEN bytes
+ * @param node The leaf node the transfer is to or from
+ * @param id The transfer id; use a new one for each transfer
+ * @param data The whole transfer
+ * @param length The number of bytes in data
+ * @param index The fragment to build, 0 to get_fragment_count() - 1
+ * @return The number of bytes in the fragment frame, or 0 if there is no
+ * such fragment.
+ */
+uint8_t build_fragment(uint8_t *buf, uint8_t node, uint8_t id, const uint8_t *data, uint16_t length,
+                       uint8_t index) {
+    uint8_t count = get_fragment_count(length);
+    if (index >= count)
+        return 0;
+
+    uint16_t offset = (uint16_t)index * FRAGMENT_PAYLOAD_SIZE;
+    uint16_t n = (length - offset > FRAGMENT_PAYLOAD_SIZE) ? FRAGMENT_PAYLOAD_SIZE : length - offset;
+
+    buf[0] = fragment;
+    buf[1] = node;
+    buf[2] = id;
+    buf[3] = index;
+    buf[4] = count;
+    memcpy(buf + FRAGMENT_HEADER_SIZE, data + offset, n);
+
+    return (uint8_t)(FRAGMENT_HEADER_SIZE + n);
+}
+
+/**
+ * @brief Get ready for a transfer
+ * @param r The reassembly
+ * @param buf Where the data will go
+ * @param size The size of buf. A transfer of count fragments is refused
+ * unless count * FRAGMENT_PAYLOAD_SIZE bytes fit, since how long the last
+ * fragment is isn't known until it arrives.
+ */
+void init_reassembly(reassembly_t *r, uint8_t *buf, uint16_t size) {
+    r->buf = buf;
+    r->size = size;
+    r->length = 0;
+    r->received = 0;
+    r->node = 0;
+    r->id = 0;
+    r->count = 0;
+}
+
+/**
+ * @brief Add a received fragment
+ *
+ * A fragment of a different transfer (node or id) than the one in
+ * progress abandons that one and starts the new one. Once a transfer is
+ * complete no transfer is in progress, so a later one may use the same
+ * id; use the data before adding the next fragment.
+ *
+ * @param r The reassembly
+ * @param frame The fragment frame
+ * @param len The number of bytes in the frame
+ * @return What became of the fragment. After fragment_complete, the data
+ * is in the buffer and r->length says how long it is.
+ */
+FragmentResult add_fragment(reassembly_t *r, const uint8_t *frame, uint8_t len) {
+    if (len < FRAGMENT_HEADER_SIZE || get_message_type(frame) != fragment)
+        return fragment_invalid;
+
+    if (message_has_crc(frame)) {
+        if (len < FRAGMENT_HEADER_SIZE + MESSAGE_CRC_SIZE || !check_message_crc(frame, len - MESSAGE_CRC_SIZE))
+            return fragment_invalid;
+        len -= MESSAGE_CRC_SIZE;
+    }
+
+    uint8_t node = frame[1], id = frame[2], index = frame[3], count = frame[4];
+    uint8_t n = len - FRAGMENT_HEADER_SIZE;
+    if (count == 0 || count > FRAGMENT_MAX_COUNT || index >= count
+        || (index < count - 1 && n != FRAGMENT_PAYLOAD_SIZE) || n > FRAGMENT_PAYLOAD_SIZE)
+        return fragment_invalid;
+
+    // Refuse a transfer that may not fit before it abandons the one in progress
+    if ((uint16_t)count * FRAGMENT_PAYLOAD_SIZE > r->size)
+        return fragment_invalid;
+
+    if (r->count == 0 || node != r->node || id != r->id || count != r->count) {
+        r->node = node;
+        r->id = id;
+        r->count = count;
+        r->received = 0;
+        r->length = 0;
+    }
+
+    uint32_t bit = (uint32_t)1 << index;
+    if (r->received & bit)
+        return fragment_duplicate;
+
+    uint16_t offset = (uint16_t)index * FRAGMENT_PAYLOAD_SIZE;
+    memcpy(r->buf + offset, frame + FRAGMENT_HEADER_SIZE, n);
+    r->received |= bit;
+    if (index == count - 1)
+        r->length = offset + n;
+
+    if (get_missing_fragments(r) != 0)
+        return fragment_added;
+
+    // r->length and the data stay for the caller
+    r->count = 0;
+    r->received = 0;
+    return fragment_complete;
+}
+
+/**
+ * @brief The fragments of the transfer in progress that have not arrived
+ * @param r The reassembly
+ * @return Bit i set == fragment i is missing; 0 if the transfer is
+ * complete or none is in progress
+ */
+uint32_t get_missing_fragments(const reassembly_t *r) {
+    if (r->count == 0)
+        return 0;
+
+    uint32_t all = (r->count == 32) ? 0xffffffff : ((uint32_t)1 << r->count) - 1;
+    return all & ~r->received;
+}
+
+/**
+ * @brief Build a NACK for the fragments that are missing
+ * @param nack The message
+ * @param r The reassembly
+ */
+void build_fragment_nack(fragment_nack_t *nack, const reassembly_t *r) {
+    fragment_nack_schema::ops::encode((uint8_t *)nack, fragment_nack, r->node, r->id, get_missing_fragments(r));
+}
+
+/**
+ * @brief Unpack a fragment NACK
+ * @param nack The message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, V-R parameter for the node
+ * @param id If not null, V-R parameter for the transfer id
+ * @param missing If not null, V-R parameter for the missing fragments;
+ * pass each set bit's index to build_fragment() to send it again
+ * @return true if this is a fragment_nack message, false otherwise.
+ */
+bool parse_fragment_nack(const fragment_nack_t *nack, uint8_t len, uint8_t *node, uint8_t *id, uint32_t *missing) {
+    if (!check_message_frame(nack, len, FRAGMENT_NACK_SIZE) || get_message_type(nack) != fragment_nack)
+        return false;
+
+    fragment_nack_schema::ops::decode((const uint8_t *)nack, 0, node, id, missing);
+    return true;
+}
+
+/**
+ * @brief Write a string representation for a fragment NACK
+ * @param nack The message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t fragment_nack_to_string(const fragment_nack_t *nack, char *buf, size_t len, bool pretty /* false */) {
+    int n;
+    if (pretty) {
+        n = snprintf(buf, len, "node: %u, transfer: %u, missing: %08lx", nack->node, nack->id,
+                     (unsigned long)nack->missing);
+    }
+    else {
+        n = snprintf(buf, len, "%u, %u, %08lx", nack->node, nack->id, (unsigned long)nack->missing);
+    }
+
+    return written_length(n, len);
+}
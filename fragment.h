@@ -0,0 +1,94 @@
+/**
+ * Transfers larger than one radio frame, e.g., config blobs and firmware
+ * deltas to a leaf, or log dumps from one.
+ *
+ * The sender splits the data into up to FRAGMENT_MAX_COUNT fragments of
+ * FRAGMENT_PAYLOAD_SIZE bytes (the last may be shorter) and sends each
+ * with build_fragment(). The receiver adds each one to a reassembly_t,
+ * which writes it straight into place in a buffer the caller provides,
+ * so one buffer is all a transfer in progress needs. Which fragments
+ * have arrived is kept as a bitmap; when the last one has been sent, or
+ * after a timeout, the receiver sends a fragment_nack listing the ones
+ * still missing and the sender sends only those again.
+ *
+ * Fragment frame layout:
+ *  byte 0: fragment
+ *  byte 1: node; the leaf node the transfer is to or from
+ *  byte 2: transfer id, chosen by the sender
+ *  byte 3: index of this fragment
+ *  byte 4: number of fragments in the transfer
+ *  then the payload
+ */
+
+#ifndef h_fragment_h
+#define h_fragment_h
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+
+#include "wire_format.h"
+#include "messages.h"
+
+/// Size of the fragment header in bytes
+#define FRAGMENT_HEADER_SIZE 5
+
+/// Payload bytes in every fragment but the last, leaving room for a CRC trailer
+#define FRAGMENT_PAYLOAD_SIZE (RH_RF95_MAX_MESSAGE_LEN - FRAGMENT_HEADER_SIZE - MESSAGE_CRC_SIZE)
+
+/// The most fragments in one transfer; one bit each in a uint32_t
+#define FRAGMENT_MAX_COUNT 32
+
+/// The most bytes in one transfer
+#define FRAGMENT_MAX_TRANSFER (FRAGMENT_MAX_COUNT * FRAGMENT_PAYLOAD_SIZE)
+
+/// Size of the fragment NACK in bytes
+#define FRAGMENT_NACK_SIZE sizeof(fragment_nack_t)
+
+/**
+ * Sent by the receiver of a transfer: the fragments it is missing.
+ */
+struct fragment_nack_t {
+    MessageType type;   // fragment_nack
+    uint8_t node;       // the leaf node the transfer is to or from
+    uint8_t id;         // transfer id
+    uint32_t missing;   // bit i set == fragment i is missing
+} PACKED;
+
+static_assert(FRAGMENT_NACK_SIZE == 7, "fragment_nack_t wire layout changed");
+
+/**
+ * The result of adding one fragment to a reassembly.
+ */
+enum FragmentResult {
+    fragment_added = 0,     // a new fragment of the transfer
+    fragment_complete = 1,  // the last missing fragment; the data is ready
+    fragment_duplicate = 2, // already received
+    fragment_invalid = 3,   // not a fragment, or does not fit the buffer
+};
+
+/**
+ * Receiver side state for one transfer.
+ */
+struct reassembly_t {
+    uint8_t *buf;           // the caller's buffer
+    uint16_t size;          // the size of buf
+    uint16_t length;        // bytes in the transfer, known once the last fragment arrives
+    uint32_t received;      // bit i set == fragment i has arrived
+    uint8_t node;
+    uint8_t id;
+    uint8_t count;          // 0 == no transfer in progress
+};
+
+uint8_t get_fragment_count(uint16_t length);
+uint8_t build_fragment(uint8_t *buf /* RH_RF95_MAX_MESSAGE_LEN */, uint8_t node, uint8_t id, const uint8_t *data,
+                       uint16_t length, uint8_t index);
+
+void init_reassembly(reassembly_t *r, uint8_t *buf, uint16_t size);
+FragmentResult add_fragment(reassembly_t *r, const uint8_t *frame, uint8_t len);
+uint32_t get_missing_fragments(const reassembly_t *r);
+
+void build_fragment_nack(fragment_nack_t *nack, const reassembly_t *r);
+bool parse_fragment_nack(const fragment_nack_t *nack, uint8_t len, uint8_t *node, uint8_t *id, uint32_t *missing);
+size_t fragment_nack_to_string(const fragment_nack_t *nack, char *buf, size_t len, bool pretty = false);
+
+#endif
@@ -0,0 +1,126 @@
+// Deduplication of packets received by more than one gateway.
+
+#include <Arduino.h>
+
+#include "gateway_merge.h"
+
+/** @name merge_entry_t::state */
+///@{
+#define MERGE_EMPTY 0
+#define MERGE_HELD 1
+#define MERGE_RELEASED 2
+///@}
+
+/**
+ * @brief Empty the cache
+ * @param merge The merge state
+ * @param hold_ms How long to wait for other copies of a packet, ms
+ * @param forget_ms How long to drop late copies of a packet, ms; at
+ * least hold_ms
+ */
+void init_gateway_merge(gateway_merge_t *merge, uint32_t hold_ms /* MERGE_HOLD_MS */,
+                        uint32_t forget_ms /* MERGE_FORGET_MS */) {
+    memset(merge->entries, 0, sizeof(merge->entries));
+    merge->hold_ms = hold_ms;
+    merge->forget_ms = forget_ms < hold_ms ? hold_ms : forget_ms;
+}
+
+/// The bit for a gateway in merge_entry_t::gateways
+static uint32_t gateway_bit(uint8_t gateway) {
+    return (uint32_t)1 << (gateway % MERGE_MAX_GATEWAYS);
+}
+
+/**
+ * @brief Add one copy of a packet
+ *
+ * A new packet goes in an empty slot or, if there is none, replaces the
+ * released packet that was first seen longest ago.
+ *
+ * @param merge The merge state
+ * @param data The packet
+ * @param gateway The number of the gateway that received it, 0 to
+ * MERGE_MAX_GATEWAYS - 1
+ * @param rssi The RSSI of the copy, dBm
+ * @param now The time, ms (e.g., millis())
+ * @return What became of this copy; merge_full only if every slot holds
+ * a packet that merge_poll() has not handed out yet.
+ */
+MergeResult merge_packet(gateway_merge_t *merge, const packet_t *data, uint8_t gateway, int16_t rssi, uint32_t now) {
+    merge_entry_t *free_entry = 0;
+    merge_entry_t *oldest_released = 0;
+
+    for (uint8_t i = 0; i < MERGE_CACHE_SLOTS; ++i) {
+        merge_entry_t *e = &merge->entries[i];
+
+        if (e->state == MERGE_RELEASED && now - e->first_seen >= merge->forget_ms)
+            e->state = MERGE_EMPTY;
+
+        if (e->state == MERGE_EMPTY) {
+            if (!free_entry)
+                free_entry = e;
+            continue;
+        }
+
+        if (e->best.packet.node != data->node || e->best.packet.message != data->message) {
+            if (e->state == MERGE_RELEASED
+                && (!oldest_released || now - e->first_seen > now - oldest_released->first_seen))
+                oldest_released = e;
+            continue;
+        }
+
+        if (!(e->gateways & gateway_bit(gateway))) {
+            e->gateways |= gateway_bit(gateway);
+            e->best.copies++;
+        }
+        if (e->state == MERGE_HELD && rssi > e->best.rssi) {
+            e->best.packet = *data;
+            e->best.rssi = rssi;
+            e->best.gateway = gateway;
+            return merge_better;
+        }
+        return merge_duplicate;
+    }
+
+    if (!free_entry)
+        free_entry = oldest_released;
+    if (!free_entry)
+        return merge_full;
+
+    free_entry->best.packet = *data;
+    free_entry->best.rssi = rssi;
+    free_entry->best.gateway = gateway;
+    free_entry->best.copies = 1;
+    free_entry->gateways = gateway_bit(gateway);
+    free_entry->first_seen = now;
+    free_entry->state = MERGE_HELD;
+
+    return merge_new;
+}
+
+/**
+ * @brief Get a packet whose hold time is up
+ *
+ * Call until it returns false, e.g., each time through loop(). Packets
+ * come out in the order they were first seen.
+ *
+ * @param merge The merge state
+ * @param now The time, ms
+ * @param out V-R parameter for the best copy of the packet
+ * @return true if a packet was returned, false if none is ready.
+ */
+bool merge_poll(gateway_merge_t *merge, uint32_t now, merged_packet_t *out) {
+    merge_entry_t *oldest = 0;
+    for (uint8_t i = 0; i < MERGE_CACHE_SLOTS; ++i) {
+        merge_entry_t *e = &merge->entries[i];
+        if (e->state == MERGE_HELD && now - e->first_seen >= merge->hold_ms
+            && (!oldest || now - e->first_seen > now - oldest->first_seen))
+            oldest = e;
+    }
+
+    if (!oldest)
+        return false;
+
+    *out = oldest->best;
+    oldest->state = MERGE_RELEASED;
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+ * Merge the packets received by several main nodes (gateways) with
+ * overlapping coverage, so that each leaf packet is stored once.
+ *
+ * Every copy of a packet, from whichever gateway, is passed to
+ * merge_packet() with the gateway's number and the RSSI it was received
+ * at. Packets are keyed on (node, message). The first copy is held for
+ * hold_ms so the other gateways' copies can arrive, and the copy with
+ * the best RSSI is kept; merge_poll() then hands it out once. Copies
+ * that arrive after that, up to forget_ms after the first, are dropped
+ * as duplicates.
+ *
+ * The cache holds MERGE_CACHE_SLOTS packets. That needs to cover the
+ * packets that arrive in forget_ms from all nodes; when there is no
+ * empty slot the oldest released packet is forgotten early, and when
+ * every slot holds a packet that has not been released merge_packet()
+ * says so and the caller should pass the packet on as is.
+ *
+ * Gateways are numbered 0 to MERGE_MAX_GATEWAYS - 1 so that each packet
+ * can count how many different gateways received it.
+ */
+
+#ifndef h_gateway_merge_h
+#define h_gateway_merge_h
+
+#include <Arduino.h>
+
+#include "data_packet.h"
+
+#define MERGE_CACHE_SLOTS 32
+
+/// Gateway numbers are 0 to MERGE_MAX_GATEWAYS - 1
+#define MERGE_MAX_GATEWAYS 32
+
+/// Default time to wait for copies from other gateways, ms
+#define MERGE_HOLD_MS 2000
+
+/// Default time to remember a packet after its first copy, ms
+#define MERGE_FORGET_MS 60000
+
+/**
+ * The result of merging one copy of a packet.
+ */
+enum MergeResult {
+    merge_new = 0,          // the first copy; held
+    merge_better = 1,       // a better copy of a held packet; replaces it
+    merge_duplicate = 2,    // drop it
+    merge_full = 3,         // no room to hold it; pass it on now
+};
+
+/**
+ * The copy of a packet that merge_poll() hands out.
+ */
+struct merged_packet_t {
+    packet_t packet;
+    int16_t rssi;           // dBm, the best RSSI of any copy
+    uint8_t gateway;        // the gateway that received this copy
+    uint8_t copies;         // how many different gateways received the packet
+};
+
+struct merge_entry_t {
+    merged_packet_t best;
+    uint32_t gateways;      // bit g set once gateway g sent a copy
+    uint32_t first_seen;    // ms
+    uint8_t state;          // empty, held or released
+};
+
+struct gateway_merge_t {
+    merge_entry_t entries[MERGE_CACHE_SLOTS];
+    uint32_t hold_ms;
+    uint32_t forget_ms;
+};
+
+void init_gateway_merge(gateway_merge_t *merge, uint32_t hold_ms = MERGE_HOLD_MS,
+                        uint32_t forget_ms = MERGE_FORGET_MS);
+MergeResult merge_packet(gateway_merge_t *merge, const packet_t *data, uint8_t gateway, int16_t rssi, uint32_t now);
+bool merge_poll(gateway_merge_t *merge, uint32_t now, merged_packet_t *out);
+
+#endif
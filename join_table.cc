@@ -0,0 +1,151 @@
+// EUI to node number table for the main node.
+
+#include <Arduino.h>
+
+#include "join_table.h"
+#include "crc16.h"
+
+/**
+ * @brief Hash an EUI to its first slot
+ * EUIs from one manufacturer share their high bytes, so mix all the
+ * bits before taking the top eight.
+ */
+static uint8_t eui_hash(uint64_t dev_eui) {
+    uint32_t h = (uint32_t)dev_eui ^ (uint32_t)(dev_eui >> 32);
+    h *= 2654435769u;   // 2^32 / golden ratio
+    return (uint8_t)(h >> 24);
+}
+
+/**
+ * @brief Find the slot that holds, or would hold, an EUI
+ * @return The slot index
+ */
+static uint8_t find_slot(const join_table_t *table, uint64_t dev_eui) {
+    uint8_t i = eui_hash(dev_eui);
+    // There are always empty slots since there are fewer nodes than slots
+    while (table->slots[i] && table->eui[table->slots[i]] != dev_eui)
+        i++;    // wraps at JOIN_TABLE_SLOTS
+
+    return i;
+}
+
+/**
+ * @brief Empty the table
+ * @param table The table
+ */
+void init_join_table(join_table_t *table) {
+    memset(table, 0, sizeof(join_table_t));
+    table->next_node = 1;
+}
+
+/**
+ * @brief Get the node number for an EUI
+ * @param table The table
+ * @param dev_eui The EUI from a join request
+ * @return The node number or 0 if the EUI has none.
+ */
+uint8_t join_table_lookup(const join_table_t *table, uint64_t dev_eui) {
+    if (dev_eui == 0)
+        return 0;
+
+    return table->slots[find_slot(table, dev_eui)];
+}
+
+/**
+ * @brief Get the node number for an EUI, assigning one if needed
+ * A leaf that joins again gets the node number it had before.
+ * @param table The table
+ * @param dev_eui The EUI from a join request
+ * @return The node number or 0 if the table is full or the EUI is 0.
+ */
+uint8_t join_table_assign(join_table_t *table, uint64_t dev_eui) {
+    if (dev_eui == 0)
+        return 0;
+
+    uint8_t i = find_slot(table, dev_eui);
+    if (table->slots[i])
+        return table->slots[i];
+
+    if (table->next_node == 0 || table->next_node > JOIN_TABLE_LAST_NODE)
+        return 0;
+
+    uint8_t node = table->next_node++;
+    table->slots[i] = node;
+    table->eui[node] = dev_eui;
+
+    return node;
+}
+
+/**
+ * @brief Get the EUI bound to a node number
+ * @param table The table
+ * @param node The node number
+ * @return The EUI or 0 if the node number is not assigned.
+ */
+uint64_t join_table_eui(const join_table_t *table, uint8_t node) {
+    return table->eui[node];
+}
+
+/**
+ * @brief Write a snapshot of the table to non-volatile storage
+ * Call this after join_table_assign() hands out a new node number and
+ * before the join_response is sent.
+ * @param table The table
+ * @param storage The storage device
+ * @param address Where to write the snapshot; it needs
+ * sizeof(join_table_image_t) + 8 * JOIN_TABLE_LAST_NODE bytes
+ * @return true if the snapshot was written, false otherwise.
+ */
+bool join_table_save(const join_table_t *table, const storage_t *storage, uint32_t address) {
+    join_table_image_t image;
+    size_t len = (table->next_node - 1) * sizeof(uint64_t);
+
+    image.magic = JOIN_TABLE_IMAGE_MAGIC;
+    image.version = JOIN_TABLE_IMAGE_VERSION;
+    image.count = table->next_node - 1;
+    image.crc = crc16((const uint8_t *)&table->eui[1], len);
+
+    // The table only grows, so writing the EUIs first leaves the old
+    // header and the EUIs it covers unchanged. A reset before the header
+    // is written loads the previous snapshot, without the newest node.
+    return storage->write(address + sizeof(image), &table->eui[1], len, storage->context)
+           && storage->write(address, &image, sizeof(image), storage->context);
+}
+
+/**
+ * @brief Load a snapshot written by join_table_save()
+ *
+ * The header is read first to get the count and CRC; the EUIs are then
+ * read in one call directly into table->eui and checked in place.
+ *
+ * @param table The table
+ * @param storage The storage device
+ * @param address Where the snapshot was written
+ * @return true if the snapshot was loaded, false if there is none, it
+ * is from another version or it is damaged. On failure the table is
+ * empty.
+ */
+bool join_table_load(join_table_t *table, const storage_t *storage, uint32_t address) {
+    join_table_image_t image;
+
+    init_join_table(table);
+    if (!storage->read(address, &image, sizeof(image), storage->context)
+        || image.magic != JOIN_TABLE_IMAGE_MAGIC || image.version != JOIN_TABLE_IMAGE_VERSION
+        || image.count > JOIN_TABLE_LAST_NODE)
+        return false;
+
+    size_t len = image.count * sizeof(uint64_t);
+    if (!storage->read(address + sizeof(image), &table->eui[1], len, storage->context)
+        || crc16((const uint8_t *)&table->eui[1], len) != image.crc) {
+        init_join_table(table);
+        return false;
+    }
+
+    for (uint16_t node = 1; node <= image.count; ++node) {
+        if (table->eui[node])
+            table->slots[find_slot(table, table->eui[node])] = (uint8_t)node;
+    }
+    table->next_node = image.count + 1;
+
+    return true;
+}
@@ -0,0 +1,63 @@
+/**
+ * The main node's table mapping leaf node EUIs to node numbers.
+ *
+ * An open-addressing hash table with linear probing. Each of the 256
+ * slots holds a node number (0 for an empty slot) and the node's EUI is
+ * held in a reverse array indexed by node number, so a lookup by EUI
+ * and a lookup by node number are both constant time in practice and
+ * the whole table is about 2.3 KB.
+ *
+ * Node numbers 1 to JOIN_TABLE_LAST_NODE are handed out in order. An
+ * EUI of 0 is not valid.
+ *
+ * join_table_save() writes a snapshot so that a main node that reboots
+ * can reload its assignments instead of making every leaf rejoin. The
+ * snapshot is a join_table_image_t header followed by the EUIs of nodes
+ * 1 to count; since node numbers are handed out in order that is every
+ * assigned node. join_table_load() makes two reads: the header, then
+ * all count EUIs at once, straight into the table.
+ *
+ * Save the table after assigning a new node number and before sending
+ * the join_response. A leaf caches the number it is given (see
+ * node_cache.h), so if the main node resets before the snapshot is
+ * written it would hand the same number to the next leaf that joins
+ * and two leaves would share it. If join_table_save() fails, do not
+ * send the response; the leaf will ask again.
+ */
+
+#ifndef h_join_table_h
+#define h_join_table_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "storage.h"
+
+#define JOIN_TABLE_SLOTS 256
+#define JOIN_TABLE_LAST_NODE 254
+
+struct join_table_t {
+    uint8_t slots[JOIN_TABLE_SLOTS];    // node number, 0 == empty
+    uint64_t eui[JOIN_TABLE_SLOTS];     // EUI for each node number
+    uint8_t next_node;                  // next unassigned node number
+};
+
+#define JOIN_TABLE_IMAGE_MAGIC 0x4a544d53    // "SMTJ"
+#define JOIN_TABLE_IMAGE_VERSION 1
+
+struct join_table_image_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t count;      // EUIs that follow, for nodes 1 to count
+    uint16_t crc;       // CRC-16 of the EUIs
+} PACKED;
+
+void init_join_table(join_table_t *table);
+uint8_t join_table_lookup(const join_table_t *table, uint64_t dev_eui);
+uint8_t join_table_assign(join_table_t *table, uint64_t dev_eui);
+uint64_t join_table_eui(const join_table_t *table, uint8_t node);
+
+bool join_table_save(const join_table_t *table, const storage_t *storage, uint32_t address);
+bool join_table_load(join_table_t *table, const storage_t *storage, uint32_t address);
+
+#endif
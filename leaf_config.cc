@@ -0,0 +1,99 @@
+// Leaf node settings and the config message.
+
+#include <Arduino.h>
+
+#include "leaf_config.h"
+#include "data_batch.h"
+
+/**
+ * @brief Set the defaults used until the main node sends a config message
+ * @param cfg The settings
+ */
+void init_leaf_config(leaf_config_t *cfg) {
+    cfg->interval = LEAF_DEFAULT_INTERVAL;
+    cfg->spreading_factor = LEAF_DEFAULT_SF;
+    cfg->tx_power = LEAF_DEFAULT_TX_POWER;
+    cfg->batch_depth = 1;
+}
+
+/**
+ * @brief Update the settings with the values from a config message
+ * Zero or out of range values are left unchanged.
+ * @return CONFIG_CHANGED_* bits for the settings that changed.
+ */
+static uint8_t apply_settings(leaf_config_t *cfg, uint16_t interval, uint8_t sf, int8_t power, uint8_t depth) {
+    uint8_t changed = 0;
+    if (interval >= LEAF_MIN_INTERVAL && interval != cfg->interval) {
+        cfg->interval = interval;
+        changed |= CONFIG_CHANGED_INTERVAL;
+    }
+    if (sf >= 7 && sf <= 12 && sf != cfg->spreading_factor) {
+        cfg->spreading_factor = sf;
+        changed |= CONFIG_CHANGED_SF;
+    }
+    if (power >= LEAF_MIN_TX_POWER && power <= LEAF_MAX_TX_POWER && power != cfg->tx_power) {
+        cfg->tx_power = power;
+        changed |= CONFIG_CHANGED_TX_POWER;
+    }
+    if (depth >= 1 && depth <= DATA_BATCH_MAX_READINGS && depth != cfg->batch_depth) {
+        cfg->batch_depth = depth;
+        changed |= CONFIG_CHANGED_BATCH_DEPTH;
+    }
+
+    return changed;
+}
+
+/**
+ * @brief Update the settings from a config message
+ *
+ * Settings that are zero in the message, or outside what the leaf can
+ * do, are left unchanged.
+ *
+ * @param cfg The settings
+ * @param msg The config message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node This leaf's node number; messages for other nodes are ignored
+ * @return CONFIG_CHANGED_* bits for the settings that changed; 0 if
+ * nothing changed. Call apply_radio_config() if the SF or power changed.
+ */
+uint8_t apply_config_message(leaf_config_t *cfg, const config_t *msg, uint8_t len, uint8_t node) {
+    uint8_t n = 0;
+    uint16_t interval = 0;
+    uint8_t sf = 0;
+    int8_t power = 0;
+    uint8_t depth = 0;
+
+    if (!parse_config(msg, len, &n, &interval, &sf, &power, &depth) || n != node)
+        return 0;
+
+    return apply_settings(cfg, interval, sf, power, depth);
+}
+
+/**
+ * @brief Update the settings from a config message in a receive buffer
+ *
+ * For use from a dispatch_message() on_config handler, which has already
+ * checked the CRC trailer.
+ *
+ * @param cfg The settings
+ * @param msg The config message
+ * @param node This leaf's node number; messages for other nodes are ignored
+ * @return CONFIG_CHANGED_* bits for the settings that changed; 0 if
+ * nothing changed or the view is not valid.
+ */
+uint8_t apply_config_message(leaf_config_t *cfg, const config_view &msg, uint8_t node) {
+    if (!msg.valid() || msg.node() != node)
+        return 0;
+
+    return apply_settings(cfg, msg.interval(), msg.spreading_factor(), msg.tx_power(), msg.batch_depth());
+}
+
+/**
+ * @brief Set the radio's spreading factor and transmit power
+ * @param rf95 The radio
+ * @param cfg The settings
+ */
+void apply_radio_config(RH_RF95 *rf95, const leaf_config_t *cfg) {
+    rf95->setSpreadingFactor(cfg->spreading_factor);
+    rf95->setTxPower(cfg->tx_power, false);
+}
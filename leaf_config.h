@@ -0,0 +1,42 @@
+/**
+ * The leaf node's reporting and radio settings, and applying a config
+ * message from the main node to them.
+ */
+
+#ifndef h_leaf_config_h
+#define h_leaf_config_h
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+
+#include "messages.h"
+#include "message_views.h"
+
+#define LEAF_DEFAULT_INTERVAL 600   // seconds
+#define LEAF_MIN_INTERVAL 10
+#define LEAF_DEFAULT_SF 7           // RH_RF95's default modem config
+#define LEAF_DEFAULT_TX_POWER 13    // dBm, RH_RF95's default
+#define LEAF_MIN_TX_POWER 2         // PA_BOOST range
+#define LEAF_MAX_TX_POWER 20
+
+/** @name Returned by apply_config_message() */
+///@{
+#define CONFIG_CHANGED_INTERVAL 0x01
+#define CONFIG_CHANGED_SF 0x02
+#define CONFIG_CHANGED_TX_POWER 0x04
+#define CONFIG_CHANGED_BATCH_DEPTH 0x08
+///@}
+
+struct leaf_config_t {
+    uint16_t interval;          // seconds between readings
+    uint8_t spreading_factor;
+    int8_t tx_power;            // dBm
+    uint8_t batch_depth;        // readings per data_batch; 1 == send each packet
+};
+
+void init_leaf_config(leaf_config_t *cfg);
+uint8_t apply_config_message(leaf_config_t *cfg, const config_t *msg, uint8_t len, uint8_t node);
+uint8_t apply_config_message(leaf_config_t *cfg, const config_view &msg, uint8_t node);
+void apply_radio_config(RH_RF95 *rf95, const leaf_config_t *cfg);
+
+#endif
@@ -0,0 +1,499 @@
+/**
+ * Compile-time descriptions of the wire layout of each message.
+ *
+ * A field is a wire_field<T, offset>; next_field<Prev, T> places a field
+ * right after the one before it, so a schema only lists its fields in
+ * order and the offsets follow. Each field reads and writes itself at its
+ * offset in a buffer (any alignment). schema_ops<field_list<...>>
+ * generates encode, decode, CSV format and size for a list of fields,
+ * and each schema's ops typedef is schema_ops for all of its fields.
+ * In a list that is only formatted, hex_field<> and fixed100_field<>
+ * change how one field is printed.
+ * Everything is a template, so it is all inlined; there are no tables
+ * at run time.
+ *
+ * The build_*(), parse_*() and *_to_string() functions of the fixed
+ * size messages in messages.cc, data_packet.cc and fragment.cc, and of
+ * the text message header, are written with these, so the schema is
+ * the one place their layout is spelled out.
+ *
+ * The schemas are checked against the message structs below, so a
+ * change to either that does not match the other will not compile.
+ */
+
+#ifndef h_message_schema_h
+#define h_message_schema_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "fast_format.h"
+#include "messages.h"
+#include "data_packet.h"
+#include "data_batch.h"
+#include "ack_bitmap.h"
+#include "data_summary.h"
+#include "fragment.h"
+#include "timing.h"
+
+template <typename T, size_t Offset>
+struct wire_field {
+    typedef T type;
+    enum : size_t { offset = Offset, size = sizeof(T), end = Offset + sizeof(T) };
+
+    // The wire format is little-endian and so is the target (see
+    // wire_format.h); memcpy() keeps the access safe at any alignment.
+    static T get(const uint8_t *buf) {
+        T value;
+        memcpy(&value, buf + offset, sizeof(T));
+        return value;
+    }
+
+    static void put(uint8_t *buf, T value) {
+        memcpy(buf + offset, &value, sizeof(T));
+    }
+};
+
+/// The first field of a message
+template <typename T>
+struct first_field : wire_field<T, 0> {};
+
+/// A field that follows Prev
+template <typename Prev, typename T>
+struct next_field : wire_field<T, Prev::end> {};
+
+template <typename... Fields>
+struct field_list {};
+
+/** @name CSV formatting of one field value */
+///@{
+inline char *format_field_value(char *p, uint8_t v) { return format_uint(p, v); }
+inline char *format_field_value(char *p, uint16_t v) { return format_uint(p, v); }
+inline char *format_field_value(char *p, uint32_t v) { return format_uint(p, v); }
+inline char *format_field_value(char *p, int8_t v) { return format_int(p, v); }
+inline char *format_field_value(char *p, int16_t v) { return format_int(p, v); }
+inline char *format_field_value(char *p, int32_t v) { return format_int(p, v); }
+inline char *format_field_value(char *p, MessageType v) { return format_uint(p, (uint8_t)v); }
+/// The most characters format_field_value() writes for a T
+template <typename T> struct field_text_len;
+template <> struct field_text_len<uint8_t> { enum : size_t { value = 3 }; };
+template <> struct field_text_len<uint16_t> { enum : size_t { value = 5 }; };
+template <> struct field_text_len<uint32_t> { enum : size_t { value = 10 }; };
+template <> struct field_text_len<int8_t> { enum : size_t { value = 4 }; };
+template <> struct field_text_len<int16_t> { enum : size_t { value = 6 }; };
+template <> struct field_text_len<int32_t> { enum : size_t { value = FORMAT_INT_MAX_LEN }; };
+template <> struct field_text_len<MessageType> { enum : size_t { value = 3 }; };
+template <> struct field_text_len<uint64_t> { enum : size_t { value = 18 }; };
+
+inline char *format_field_value(char *p, uint64_t v) {
+    p = format_hex_byte(p, (uint8_t)(v >> 56));
+    for (int8_t shift = 48; shift >= 0; shift -= 8) {
+        char hex[FORMAT_HEX_BYTE_LEN];
+        format_hex_byte(hex, (uint8_t)(v >> shift));
+        *p++ = hex[2];
+        *p++ = hex[3];
+    }
+    return p;
+}
+
+/// Print a field with format_field_value()
+template <typename Field>
+struct field_format {
+    enum : size_t { text_len = field_text_len<typename Field::type>::value };
+    static char *format(char *p, const uint8_t *buf) { return format_field_value(p, Field::get(buf)); }
+};
+
+/// Print a uint8_t field as '0x' and two hex digits
+template <typename Field>
+struct hex_field : Field {};
+
+template <typename Field>
+struct field_format<hex_field<Field> > {
+    enum : size_t { text_len = FORMAT_HEX_BYTE_LEN };
+    static char *format(char *p, const uint8_t *buf) { return format_hex_byte(p, Field::get(buf)); }
+};
+
+/// Print a value * 100 field with two decimal places
+template <typename Field>
+struct fixed100_field : Field {};
+
+template <typename Field>
+struct field_format<fixed100_field<Field> > {
+    enum : size_t { text_len = field_text_len<typename Field::type>::value + 1 };
+    static char *format(char *p, const uint8_t *buf) { return format_fixed100(p, Field::get(buf)); }
+};
+///@}
+
+template <typename List>
+struct schema_ops;
+
+template <>
+struct schema_ops<field_list<> > {
+    enum : size_t { size = 0, text_len = 0 };
+};
+
+template <typename First, typename... Rest>
+struct schema_ops<field_list<First, Rest...> > {
+    enum : size_t {
+        size = First::size + schema_ops<field_list<Rest...> >::size,
+        /// The longest text format() writes
+        text_len = field_format<First>::text_len + (sizeof...(Rest) ? 2 : 0)
+                   + schema_ops<field_list<Rest...> >::text_len
+    };
+
+    /// Write every field
+    static void encode(uint8_t *buf, typename First::type first, typename Rest::type... rest) {
+        First::put(buf, first);
+        int expand[] = {0, (Rest::put(buf, rest), 0)...};
+        (void)expand;
+    }
+
+    /// Read every field whose V-R parameter is not null
+    static void decode(const uint8_t *buf, typename First::type *first, typename Rest::type *... rest) {
+        if (first)
+            *first = First::get(buf);
+        int expand[] = {0, (rest ? (*rest = Rest::get(buf), 0) : 0)...};
+        (void)expand;
+    }
+
+    /// Write the field values as ", " separated text, without a null
+    static char *format(char *p, const uint8_t *buf) {
+        p = field_format<First>::format(p, buf);
+        int expand[] = {0, (*p++ = ',', *p++ = ' ', p = field_format<Rest>::format(p, buf), 0)...};
+        (void)expand;
+        return p;
+    }
+};
+
+/**
+ * @brief Write the fields of List as a CSV line
+ * @param msg The message
+ * @param buf Destination for the line, always null terminated
+ * @param len The size of buf
+ * @return The number of characters written, not counting the null.
+ */
+template <typename List>
+size_t format_fields(const void *msg, char *buf, size_t len) {
+    if (len == 0)
+        return 0;
+
+    char tmp[schema_ops<List>::text_len + 1];
+    char *start = (len > schema_ops<List>::text_len) ? buf : tmp;
+    size_t n = schema_ops<List>::format(start, (const uint8_t *)msg) - start;
+    if (start == tmp) {
+        n = (n < len) ? n : len - 1;
+        memcpy(buf, tmp, n);
+    }
+    buf[n] = '\0';
+
+    return n;
+}
+
+/** @name Message schemas */
+///@{
+struct join_request_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint64_t> dev_eui;
+    typedef next_field<dev_eui, uint8_t> protocol;
+    typedef next_field<protocol, uint8_t> capabilities;
+    typedef field_list<message_type, dev_eui, protocol, capabilities> fields;
+    typedef schema_ops<fields> ops;
+};
+
+struct join_response_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint8_t> leaf_node;
+    typedef next_field<leaf_node, uint32_t> time;
+    typedef next_field<time, uint8_t> slot;
+    typedef next_field<slot, uint8_t> slot_length;
+    typedef next_field<slot_length, uint16_t> frame_length;
+    typedef next_field<frame_length, uint8_t> protocol;
+    typedef next_field<protocol, MessageType> encoding;
+    typedef field_list<message_type, node, leaf_node, time, slot, slot_length, frame_length, protocol,
+                       encoding> fields;
+    typedef schema_ops<fields> ops;
+    /// The values join_response_to_string() prints
+    typedef field_list<node, time, slot, slot_length, frame_length, encoding> csv;
+};
+
+struct time_request_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef field_list<message_type, node> fields;
+    typedef schema_ops<fields> ops;
+};
+
+struct time_response_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint32_t> time;
+    typedef next_field<time, uint8_t> slot;
+    typedef next_field<slot, uint8_t> slot_length;
+    typedef next_field<slot_length, uint16_t> frame_length;
+    typedef field_list<message_type, node, time, slot, slot_length, frame_length> fields;
+    typedef schema_ops<fields> ops;
+    /// The values time_response_to_string() prints
+    typedef field_list<node, time, slot, slot_length, frame_length> csv;
+};
+
+struct config_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint16_t> interval;
+    typedef next_field<interval, uint8_t> spreading_factor;
+    typedef next_field<spreading_factor, int8_t> tx_power;
+    typedef next_field<tx_power, uint8_t> batch_depth;
+    typedef field_list<message_type, node, interval, spreading_factor, tx_power, batch_depth> fields;
+    typedef schema_ops<fields> ops;
+    /// The values config_to_string() prints
+    typedef field_list<node, interval, spreading_factor, tx_power, batch_depth> csv;
+};
+
+/// The text header; the characters follow
+struct text_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint8_t> length;
+    typedef field_list<message_type, node, length> fields;
+    typedef schema_ops<fields> ops;
+    /// The values text_message_to_string() prints before the text
+    typedef field_list<node> csv;
+};
+
+struct data_packet_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint32_t> message;
+    typedef next_field<message, uint32_t> time;
+    typedef next_field<time, uint16_t> battery;
+    typedef next_field<battery, uint16_t> last_tx_duration;
+    typedef next_field<last_tx_duration, int16_t> temp;
+    typedef next_field<temp, uint16_t> humidity;
+    typedef next_field<humidity, uint8_t> status;
+    typedef next_field<status, uint8_t> data;
+    typedef next_field<data, uint8_t> node;
+    typedef field_list<message_type, message, time, battery, last_tx_duration, temp, humidity, status, data,
+                       node> fields;
+    typedef schema_ops<fields> ops;
+    /// The values data_packet_to_csv() prints
+    typedef field_list<node, message, time, battery, last_tx_duration, temp, humidity, hex_field<status> > csv;
+    /// ... and with 'scaled' true
+    typedef field_list<node, message, time, fixed100_field<battery>, last_tx_duration, fixed100_field<temp>,
+                       fixed100_field<humidity>, hex_field<status> > scaled_csv;
+};
+
+/// The batch header; count readings follow
+struct data_batch_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint8_t> count;
+    typedef next_field<count, uint32_t> message;
+    typedef next_field<message, uint32_t> time;
+    typedef field_list<message_type, node, count, message, time> fields;
+    typedef schema_ops<fields> ops;
+};
+
+/// One batch reading, offsets from the start of the reading
+struct batch_reading_schema {
+    typedef first_field<uint16_t> time_offset;
+    typedef next_field<time_offset, uint16_t> battery;
+    typedef next_field<battery, uint16_t> last_tx_duration;
+    typedef next_field<last_tx_duration, int16_t> temp;
+    typedef next_field<temp, uint16_t> humidity;
+    typedef next_field<humidity, uint8_t> status;
+    typedef next_field<status, uint8_t> data;
+    typedef field_list<time_offset, battery, last_tx_duration, temp, humidity, status, data> fields;
+    typedef schema_ops<fields> ops;
+};
+
+struct data_summary_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint32_t> message;
+    typedef next_field<message, uint32_t> time;
+    typedef next_field<time, uint16_t> duration;
+    typedef next_field<duration, uint8_t> count;
+    typedef next_field<count, uint8_t> status;
+    typedef next_field<status, uint16_t> battery_mean;
+    typedef next_field<battery_mean, uint16_t> battery_min;
+    typedef next_field<battery_min, uint16_t> battery_max;
+    typedef next_field<battery_max, int16_t> temp_mean;
+    typedef next_field<temp_mean, int16_t> temp_min;
+    typedef next_field<temp_min, int16_t> temp_max;
+    typedef next_field<temp_max, uint16_t> humidity_mean;
+    typedef next_field<humidity_mean, uint16_t> humidity_min;
+    typedef next_field<humidity_min, uint16_t> humidity_max;
+    typedef next_field<humidity_max, uint16_t> moisture_mean;
+    typedef next_field<moisture_mean, uint16_t> moisture_min;
+    typedef next_field<moisture_min, uint16_t> moisture_max;
+    typedef field_list<message_type, node, message, time, duration, count, status, battery_mean, battery_min,
+                       battery_max, temp_mean, temp_min, temp_max, humidity_mean, humidity_min, humidity_max,
+                       moisture_mean, moisture_min, moisture_max> fields;
+    typedef schema_ops<fields> ops;
+};
+
+struct fragment_nack_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint8_t> id;
+    typedef next_field<id, uint32_t> missing;
+    typedef field_list<message_type, node, id, missing> fields;
+    typedef schema_ops<fields> ops;
+};
+
+/// The ack_bitmap header; count entries follow
+struct ack_bitmap_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef next_field<node, uint32_t> time;
+    typedef next_field<time, uint8_t> count;
+    typedef field_list<message_type, node, time, count> fields;
+    typedef schema_ops<fields> ops;
+};
+
+/// One ack_bitmap entry, offsets from the start of the entry
+struct ack_entry_schema {
+    typedef first_field<uint8_t> node;
+    typedef next_field<node, uint16_t> message;
+    typedef next_field<message, uint8_t> bitmap;
+    typedef field_list<node, message, bitmap> fields;
+    typedef schema_ops<fields> ops;
+};
+
+/// The timing report header; TIMING_SECTIONS entries follow
+struct timing_report_schema {
+    typedef first_field<MessageType> message_type;
+    typedef next_field<message_type, uint8_t> node;
+    typedef field_list<message_type, node> fields;
+    typedef schema_ops<fields> ops;
+};
+
+/// One timing report entry, offsets from the start of the entry
+struct timing_report_entry_schema {
+    typedef first_field<uint16_t> count;
+    typedef next_field<count, uint32_t> min;
+    typedef next_field<min, uint32_t> max;
+    typedef next_field<max, uint32_t> mean;
+    typedef field_list<count, min, max, mean> fields;
+    typedef schema_ops<fields> ops;
+};
+///@}
+
+// Check a schema field against the matching struct member
+#define CHECK_FIELD(schema, type, field) \
+    static_assert(schema::field::offset == offsetof(type, field) && schema::field::size == sizeof(type::field), \
+                  #type "::" #field " does not match " #schema)
+
+CHECK_FIELD(join_request_schema, join_request_t, dev_eui);
+CHECK_FIELD(join_request_schema, join_request_t, protocol);
+CHECK_FIELD(join_request_schema, join_request_t, capabilities);
+static_assert(join_request_schema::ops::size == JOIN_REQUEST_SIZE, "join_request_schema size");
+
+CHECK_FIELD(join_response_schema, join_response_t, node);
+CHECK_FIELD(join_response_schema, join_response_t, leaf_node);
+CHECK_FIELD(join_response_schema, join_response_t, time);
+CHECK_FIELD(join_response_schema, join_response_t, slot);
+CHECK_FIELD(join_response_schema, join_response_t, slot_length);
+CHECK_FIELD(join_response_schema, join_response_t, frame_length);
+CHECK_FIELD(join_response_schema, join_response_t, protocol);
+CHECK_FIELD(join_response_schema, join_response_t, encoding);
+static_assert(join_response_schema::ops::size == JOIN_RESPONSE_SIZE, "join_response_schema size");
+
+CHECK_FIELD(time_request_schema, time_request_t, node);
+static_assert(time_request_schema::ops::size == TIME_REQUEST_SIZE, "time_request_schema size");
+
+CHECK_FIELD(time_response_schema, time_response_t, node);
+CHECK_FIELD(time_response_schema, time_response_t, time);
+CHECK_FIELD(time_response_schema, time_response_t, slot);
+CHECK_FIELD(time_response_schema, time_response_t, slot_length);
+CHECK_FIELD(time_response_schema, time_response_t, frame_length);
+static_assert(time_response_schema::ops::size == TIME_RESPONSE_SIZE, "time_response_schema size");
+
+CHECK_FIELD(config_schema, config_t, node);
+CHECK_FIELD(config_schema, config_t, interval);
+CHECK_FIELD(config_schema, config_t, spreading_factor);
+CHECK_FIELD(config_schema, config_t, tx_power);
+CHECK_FIELD(config_schema, config_t, batch_depth);
+static_assert(config_schema::ops::size == CONFIG_SIZE, "config_schema size");
+
+CHECK_FIELD(text_schema, text_t, node);
+CHECK_FIELD(text_schema, text_t, length);
+static_assert(text_schema::ops::size == offsetof(text_t, buf), "text_schema size");
+
+CHECK_FIELD(data_packet_schema, packet_t, message);
+CHECK_FIELD(data_packet_schema, packet_t, time);
+CHECK_FIELD(data_packet_schema, packet_t, battery);
+CHECK_FIELD(data_packet_schema, packet_t, last_tx_duration);
+CHECK_FIELD(data_packet_schema, packet_t, temp);
+CHECK_FIELD(data_packet_schema, packet_t, humidity);
+CHECK_FIELD(data_packet_schema, packet_t, status);
+CHECK_FIELD(data_packet_schema, packet_t, data);
+CHECK_FIELD(data_packet_schema, packet_t, node);
+static_assert(data_packet_schema::ops::size == DATA_PACKET_SIZE, "data_packet_schema size");
+static_assert(schema_ops<data_packet_schema::scaled_csv>::text_len < DATA_PACKET_CSV_LEN,
+              "DATA_PACKET_CSV_LEN is too small");
+
+CHECK_FIELD(data_batch_schema, data_batch_t, node);
+CHECK_FIELD(data_batch_schema, data_batch_t, count);
+CHECK_FIELD(data_batch_schema, data_batch_t, message);
+CHECK_FIELD(data_batch_schema, data_batch_t, time);
+static_assert(data_batch_schema::ops::size == DATA_BATCH_HEADER_SIZE, "data_batch_schema size");
+
+CHECK_FIELD(batch_reading_schema, batch_reading_t, time_offset);
+CHECK_FIELD(batch_reading_schema, batch_reading_t, battery);
+CHECK_FIELD(batch_reading_schema, batch_reading_t, last_tx_duration);
+CHECK_FIELD(batch_reading_schema, batch_reading_t, temp);
+CHECK_FIELD(batch_reading_schema, batch_reading_t, humidity);
+CHECK_FIELD(batch_reading_schema, batch_reading_t, status);
+CHECK_FIELD(batch_reading_schema, batch_reading_t, data);
+static_assert(batch_reading_schema::ops::size == sizeof(batch_reading_t), "batch_reading_schema size");
+
+CHECK_FIELD(data_summary_schema, data_summary_t, node);
+CHECK_FIELD(data_summary_schema, data_summary_t, message);
+CHECK_FIELD(data_summary_schema, data_summary_t, time);
+CHECK_FIELD(data_summary_schema, data_summary_t, duration);
+CHECK_FIELD(data_summary_schema, data_summary_t, count);
+CHECK_FIELD(data_summary_schema, data_summary_t, status);
+CHECK_FIELD(data_summary_schema, data_summary_t, battery_mean);
+CHECK_FIELD(data_summary_schema, data_summary_t, battery_min);
+CHECK_FIELD(data_summary_schema, data_summary_t, battery_max);
+CHECK_FIELD(data_summary_schema, data_summary_t, temp_mean);
+CHECK_FIELD(data_summary_schema, data_summary_t, temp_min);
+CHECK_FIELD(data_summary_schema, data_summary_t, temp_max);
+CHECK_FIELD(data_summary_schema, data_summary_t, humidity_mean);
+CHECK_FIELD(data_summary_schema, data_summary_t, humidity_min);
+CHECK_FIELD(data_summary_schema, data_summary_t, humidity_max);
+CHECK_FIELD(data_summary_schema, data_summary_t, moisture_mean);
+CHECK_FIELD(data_summary_schema, data_summary_t, moisture_min);
+CHECK_FIELD(data_summary_schema, data_summary_t, moisture_max);
+static_assert(data_summary_schema::ops::size == DATA_SUMMARY_SIZE, "data_summary_schema size");
+
+CHECK_FIELD(fragment_nack_schema, fragment_nack_t, node);
+CHECK_FIELD(fragment_nack_schema, fragment_nack_t, id);
+CHECK_FIELD(fragment_nack_schema, fragment_nack_t, missing);
+static_assert(fragment_nack_schema::ops::size == FRAGMENT_NACK_SIZE, "fragment_nack_schema size");
+
+CHECK_FIELD(ack_bitmap_schema, ack_bitmap_t, node);
+CHECK_FIELD(ack_bitmap_schema, ack_bitmap_t, time);
+CHECK_FIELD(ack_bitmap_schema, ack_bitmap_t, count);
+static_assert(ack_bitmap_schema::ops::size == ACK_BITMAP_HEADER_SIZE, "ack_bitmap_schema size");
+
+CHECK_FIELD(ack_entry_schema, ack_entry_t, node);
+CHECK_FIELD(ack_entry_schema, ack_entry_t, message);
+CHECK_FIELD(ack_entry_schema, ack_entry_t, bitmap);
+static_assert(ack_entry_schema::ops::size == sizeof(ack_entry_t), "ack_entry_schema size");
+
+CHECK_FIELD(timing_report_schema, timing_report_t, node);
+static_assert(timing_report_schema::ops::size == offsetof(timing_report_t, sections),
+              "timing_report_schema size");
+
+CHECK_FIELD(timing_report_entry_schema, timing_report_entry_t, count);
+CHECK_FIELD(timing_report_entry_schema, timing_report_entry_t, min);
+CHECK_FIELD(timing_report_entry_schema, timing_report_entry_t, max);
+CHECK_FIELD(timing_report_entry_schema, timing_report_entry_t, mean);
+static_assert(timing_report_entry_schema::ops::size == sizeof(timing_report_entry_t),
+              "timing_report_entry_schema size");
+
+#undef CHECK_FIELD
+
+#endif
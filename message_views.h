@@ -0,0 +1,300 @@
+/**
+ * Read-only views of messages in a receive buffer.
+ *
+ * The parse_*() functions copy each field into a caller's variables.
+ * A view instead wraps the buffer filled by RH_RF95::recv() and reads
+ * each field from it when asked, so nothing is copied. Check valid()
+ * before using any other accessor; it tests the message type and that
+ * the buffer is long enough for the message (and that a join request is
+ * from a leaf no older than PROTOCOL_MIN_VERSION). A view does not check a
+ * CRC trailer; dispatch_message() does that before making the view.
+ *
+ * The field offsets come from the schemas in message_schema.h.
+ *
+ * The buffer must outlive the view.
+ */
+
+#ifndef h_message_views_h
+#define h_message_views_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "messages.h"
+#include "data_packet.h"
+#include "data_batch.h"
+#include "ack_bitmap.h"
+#include "data_summary.h"
+#include "fragment.h"
+#include "timing.h"
+#include "message_schema.h"
+
+class join_request_view {
+    typedef join_request_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    join_request_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const {
+        return d_len >= JOIN_REQUEST_SIZE && get_message_type(d_buf) == join_request
+               && S::protocol::get(d_buf) >= PROTOCOL_MIN_VERSION;
+    }
+    uint64_t dev_eui() const { return S::dev_eui::get(d_buf); }
+    uint8_t protocol() const { return S::protocol::get(d_buf); }
+    uint8_t capabilities() const { return S::capabilities::get(d_buf); }
+};
+
+class join_response_view {
+    typedef join_response_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    join_response_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= JOIN_RESPONSE_SIZE && get_message_type(d_buf) == join_response; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint8_t leaf_node() const { return S::leaf_node::get(d_buf); }
+    uint32_t time() const { return S::time::get(d_buf); }
+    uint8_t slot() const { return S::slot::get(d_buf); }
+    uint8_t slot_length() const { return S::slot_length::get(d_buf); }
+    uint16_t frame_length() const { return S::frame_length::get(d_buf); }
+    uint8_t protocol() const { return S::protocol::get(d_buf); }
+    MessageType encoding() const { return S::encoding::get(d_buf); }
+};
+
+class time_request_view {
+    typedef time_request_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    time_request_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= TIME_REQUEST_SIZE && get_message_type(d_buf) == time_request; }
+    uint8_t node() const { return S::node::get(d_buf); }
+};
+
+class time_response_view {
+    typedef time_response_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    time_response_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= TIME_RESPONSE_SIZE && get_message_type(d_buf) == time_response; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint32_t time() const { return S::time::get(d_buf); }
+    uint8_t slot() const { return S::slot::get(d_buf); }
+    uint8_t slot_length() const { return S::slot_length::get(d_buf); }
+    uint16_t frame_length() const { return S::frame_length::get(d_buf); }
+};
+
+class config_view {
+    typedef config_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    config_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= CONFIG_SIZE && get_message_type(d_buf) == config; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint16_t interval() const { return S::interval::get(d_buf); }
+    uint8_t spreading_factor() const { return S::spreading_factor::get(d_buf); }
+    int8_t tx_power() const { return S::tx_power::get(d_buf); }
+    uint8_t batch_depth() const { return S::batch_depth::get(d_buf); }
+};
+
+/**
+ * A text message. text() points into the receive buffer and is not
+ * null terminated; use length().
+ */
+class text_view {
+    typedef text_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    text_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const {
+        return d_len >= S::length::end && get_message_type(d_buf) == MessageType::text
+               && length() <= TEXT_BUF_LEN && S::length::end + length() <= d_len;
+    }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint8_t length() const { return S::length::get(d_buf); }
+    const uint8_t *text() const { return d_buf + S::length::end; }
+};
+
+class data_packet_view {
+    typedef data_packet_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    data_packet_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= DATA_PACKET_SIZE && get_message_type(d_buf) == data_packet; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint32_t message() const { return S::message::get(d_buf); }
+    uint32_t time() const { return S::time::get(d_buf); }
+    uint16_t battery() const { return S::battery::get(d_buf); }
+    uint16_t last_tx_duration() const { return S::last_tx_duration::get(d_buf); }
+    int16_t temp() const { return S::temp::get(d_buf); }
+    uint16_t humidity() const { return S::humidity::get(d_buf); }
+    uint8_t status() const { return S::status::get(d_buf); }
+    uint8_t data() const { return S::data::get(d_buf); }
+};
+
+/**
+ * A data batch. The per-reading accessors take the reading's index,
+ * 0 to count() - 1.
+ */
+class data_batch_view {
+    typedef data_batch_schema S;
+    typedef batch_reading_schema R;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+    const uint8_t *reading(uint8_t i) const {
+        return d_buf + DATA_BATCH_HEADER_SIZE + i * sizeof(batch_reading_t);
+    }
+
+public:
+    data_batch_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const {
+        return d_len >= DATA_BATCH_HEADER_SIZE && get_message_type(d_buf) == data_batch
+               && count() <= DATA_BATCH_MAX_READINGS
+               && DATA_BATCH_HEADER_SIZE + count() * sizeof(batch_reading_t) <= d_len;
+    }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint8_t count() const { return S::count::get(d_buf); }
+    uint32_t base_message() const { return S::message::get(d_buf); }
+    uint32_t base_time() const { return S::time::get(d_buf); }
+
+    uint32_t message(uint8_t i) const { return base_message() + i; }
+    uint32_t time(uint8_t i) const { return base_time() + R::time_offset::get(reading(i)); }
+    uint16_t battery(uint8_t i) const { return R::battery::get(reading(i)); }
+    uint16_t last_tx_duration(uint8_t i) const { return R::last_tx_duration::get(reading(i)); }
+    int16_t temp(uint8_t i) const { return R::temp::get(reading(i)); }
+    uint16_t humidity(uint8_t i) const { return R::humidity::get(reading(i)); }
+    uint8_t status(uint8_t i) const { return R::status::get(reading(i)); }
+    uint8_t data(uint8_t i) const { return R::data::get(reading(i)); }
+};
+
+/**
+ * A data summary.
+ */
+class data_summary_view {
+    typedef data_summary_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    data_summary_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= DATA_SUMMARY_SIZE && get_message_type(d_buf) == data_summary; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint32_t message() const { return S::message::get(d_buf); }
+    uint32_t time() const { return S::time::get(d_buf); }
+    uint16_t duration() const { return S::duration::get(d_buf); }
+    uint8_t count() const { return S::count::get(d_buf); }
+    uint8_t status() const { return S::status::get(d_buf); }
+    uint16_t battery_mean() const { return S::battery_mean::get(d_buf); }
+    uint16_t battery_min() const { return S::battery_min::get(d_buf); }
+    uint16_t battery_max() const { return S::battery_max::get(d_buf); }
+    int16_t temp_mean() const { return S::temp_mean::get(d_buf); }
+    int16_t temp_min() const { return S::temp_min::get(d_buf); }
+    int16_t temp_max() const { return S::temp_max::get(d_buf); }
+    uint16_t humidity_mean() const { return S::humidity_mean::get(d_buf); }
+    uint16_t humidity_min() const { return S::humidity_min::get(d_buf); }
+    uint16_t humidity_max() const { return S::humidity_max::get(d_buf); }
+    uint16_t moisture_mean() const { return S::moisture_mean::get(d_buf); }
+    uint16_t moisture_min() const { return S::moisture_min::get(d_buf); }
+    uint16_t moisture_max() const { return S::moisture_max::get(d_buf); }
+};
+
+class fragment_nack_view {
+    typedef fragment_nack_schema S;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+public:
+    fragment_nack_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= FRAGMENT_NACK_SIZE && get_message_type(d_buf) == fragment_nack; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint8_t id() const { return S::id::get(d_buf); }
+    uint32_t missing() const { return S::missing::get(d_buf); }
+};
+
+/**
+ * An ack_bitmap. The per-entry accessors take the entry's index,
+ * 0 to count() - 1.
+ */
+class ack_bitmap_view {
+    typedef ack_bitmap_schema S;
+    typedef ack_entry_schema E;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+    const uint8_t *entry(uint8_t i) const {
+        return d_buf + ACK_BITMAP_HEADER_SIZE + i * sizeof(ack_entry_t);
+    }
+
+public:
+    ack_bitmap_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const {
+        return d_len >= ACK_BITMAP_HEADER_SIZE && get_message_type(d_buf) == ack_bitmap
+               && count() <= ACK_BITMAP_MAX_ENTRIES
+               && ACK_BITMAP_HEADER_SIZE + count() * sizeof(ack_entry_t) <= d_len;
+    }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint32_t time() const { return S::time::get(d_buf); }
+    uint8_t count() const { return S::count::get(d_buf); }
+
+    uint8_t leaf_node(uint8_t i) const { return E::node::get(entry(i)); }
+    uint16_t message(uint8_t i) const { return E::message::get(entry(i)); }
+    uint8_t bitmap(uint8_t i) const { return E::bitmap::get(entry(i)); }
+
+    /// True if this acknowledges message from leaf_node
+    bool acks(uint8_t leaf_node, uint32_t message) const {
+        for (uint8_t i = 0; i < count(); ++i) {
+            if (E::node::get(entry(i)) == leaf_node)
+                return ack_entry_acks(E::message::get(entry(i)), E::bitmap::get(entry(i)), message);
+        }
+        return false;
+    }
+};
+
+/**
+ * A timing report. The per-section accessors take a TimingSection.
+ */
+class timing_report_view {
+    typedef timing_report_schema S;
+    typedef timing_report_entry_schema E;
+    const uint8_t *d_buf;
+    uint8_t d_len;
+
+    const uint8_t *entry(TimingSection s) const {
+        return d_buf + offsetof(timing_report_t, sections) + s * sizeof(timing_report_entry_t);
+    }
+
+public:
+    timing_report_view(const uint8_t *buf, uint8_t len) : d_buf(buf), d_len(len) {}
+
+    bool valid() const { return d_len >= TIMING_REPORT_SIZE && get_message_type(d_buf) == timing_report; }
+    uint8_t node() const { return S::node::get(d_buf); }
+    uint16_t count(TimingSection s) const { return E::count::get(entry(s)); }
+    uint32_t min(TimingSection s) const { return E::min::get(entry(s)); }
+    uint32_t max(TimingSection s) const { return E::max::get(entry(s)); }
+    uint32_t mean(TimingSection s) const { return E::mean::get(entry(s)); }
+};
+
+#endif
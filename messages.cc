@@ -6,21 +6,23 @@
 
 #include <Arduino.h>
 #include <messages.h>
+#include "crc16.h"
+#include "data_packet.h"
+#include "data_batch.h"
+#include "message_schema.h"
 
 /**
  * @brief Get MessageType field of any of the messages
  *
  * This assumes \c message is really a buffer with one of the messages
- * in it and that the type field is first. If this is used on a data
- * packet, the results are undefined.
+ * in it. Every message, including the data packet, starts with its
+ * one byte type. The CRC flag, if set, is not part of the type.
  *
  * @param message A pointer to the message
  * @return the Message Type.
  */
-MessageType get_message_type(void *message) {
-    MessageType type;
-    memcpy(&type, message, sizeof(MessageType));
-    return type;
+MessageType get_message_type(const void *message) {
+    return (MessageType)(*(const uint8_t *)message & ~MESSAGE_CRC_FLAG);
 }
 
 /**
@@ -40,67 +42,180 @@ char *get_message_type_string(MessageType type) {
         case error:
             return (char*)"error";
 #endif
+        case ack_bitmap:
+            return (char*)"ack bitmap";
+        case config:
+            return (char*)"config";
         case data_packet:
             return (char*)"data packet";
         case text:
             return (char*)"text";
+        case data_delta:
+            return (char*)"data delta";
+        case data_batch:
+            return (char*)"data batch";
+        case timing_report:
+            return (char*)"timing report";
+        case stats:
+            return (char*)"stats";
+        case data_packed:
+            return (char*)"data packed";
+        case data_sensors:
+            return (char*)"data sensors";
+        case data_summary:
+            return (char*)"data summary";
+        case fragment:
+            return (char*)"fragment";
+        case fragment_nack:
+            return (char*)"fragment nack";
 
         default:
             return (char*)"unknown";
     }
 }
 
+/** @name CRC trailer
+ * Any message may end with a CRC-16 of all of its bytes, including the
+ * type byte with MESSAGE_CRC_FLAG set. The trailer is optional; a
+ * message without the flag is accepted as is. The parse_*() functions
+ * check the trailer when the flag is set, so the buffer passed to them
+ * must include it.
+ */
+///@{
+/**
+ * @brief Does this message end with a CRC trailer?
+ * @param message A pointer to the message
+ */
+bool message_has_crc(const void *message) {
+    return *(const uint8_t *)message & MESSAGE_CRC_FLAG;
+}
+
+/**
+ * @brief Add a CRC trailer to a message built in a buffer
+ * Call this after the build_*() function and send the returned
+ * number of bytes.
+ * @param message The message
+ * @param len The number of bytes in the message
+ * @param size The size of the buffer holding the message
+ * @return The length of the message with its trailer, or 0 if the
+ * trailer does not fit in the buffer or in one radio frame.
+ */
+size_t add_message_crc(void *message, size_t len, size_t size) {
+    if (len == 0 || len + MESSAGE_CRC_SIZE > size || len + MESSAGE_CRC_SIZE > RH_RF95_MAX_MESSAGE_LEN)
+        return 0;
+
+    uint8_t *buf = (uint8_t *)message;
+    buf[0] |= MESSAGE_CRC_FLAG;
+    uint16_t crc = crc16(buf, len);
+    buf[len] = (uint8_t)crc;
+    buf[len + 1] = (uint8_t)(crc >> 8);
+
+    return len + MESSAGE_CRC_SIZE;
+}
+
+/**
+ * @brief Check the CRC trailer of a message, if it has one
+ * @param message The message
+ * @param len The number of bytes in the message, not counting the trailer
+ * @return true if the message has no trailer or the trailer matches,
+ * false otherwise.
+ */
+bool check_message_crc(const void *message, size_t len) {
+    if (!message_has_crc(message))
+        return true;
+
+    if (len + MESSAGE_CRC_SIZE > RH_RF95_MAX_MESSAGE_LEN)
+        return false;
+
+    const uint8_t *buf = (const uint8_t *)message;
+    return crc16(buf, len) == (uint16_t)(buf[len] | (buf[len + 1] << 8));
+}
+
+/**
+ * @brief Check that a received frame holds a whole message
+ *
+ * If the message has a CRC trailer, the trailer is the last two bytes of
+ * the frame and must match.
+ *
+ * @param message The frame
+ * @param len The number of bytes received, including any CRC trailer
+ * @param size The size of the message, not counting the trailer
+ * @return true if the frame is long enough and its trailer (if any)
+ * matches, false otherwise.
+ */
+bool check_message_frame(const void *message, size_t len, size_t size) {
+    if (len < size || len == 0)
+        return false;
+
+    if (!message_has_crc(message))
+        return true;
+
+    return len >= size + MESSAGE_CRC_SIZE && check_message_crc(message, len - MESSAGE_CRC_SIZE);
+}
+///@}
+
 /** @name Join Request */
 ///@{
 /**
  * @brief Build a join_request message
  * @param jr Pointer to join_request_t structure
  * @param dev_eui The EUI for this leaf node
+ * @param capabilities The CAPABILITY_* bits for the encodings this leaf
+ * sends; by default, all of them
  */
-void build_join_request(join_request_t *jr, uint64_t dev_eui) {
-    jr->type = join_request;
-    jr->dev_eui = dev_eui;
+void build_join_request(join_request_t *jr, uint64_t dev_eui, uint8_t capabilities /*PROTOCOL_CAPABILITIES*/) {
+    join_request_schema::ops::encode((uint8_t *)jr, join_request, dev_eui, PROTOCOL_VERSION, capabilities);
 }
 
 /**
  * @brief extract information from a join_request message
+ * @param data The received message
+ * @param len The number of bytes received, including any CRC trailer
  * @param dev_eui If not null, returns the deveice EUI of the requesting leaf node
- * @return true is this is a join_request message, false otehrwise.
+ * @param protocol If not null, returns the leaf's protocol version
+ * @param capabilities If not null, returns the leaf's CAPABILITY_* bits
+ * @return true is this is a join_request message, false otehrwise. Also
+ * false if the leaf's protocol version is older than PROTOCOL_MIN_VERSION;
+ * don't answer it, but log it with join_request_to_string() so the leaf
+ * can be found and updated.
  */
-bool parse_join_request(const join_request_t *data, uint64_t *dev_eui) {
-    if (data->type != join_request)
+bool parse_join_request(const join_request_t *data, uint8_t len, uint64_t *dev_eui, uint8_t *protocol /*0*/,
+                        uint8_t *capabilities /*0*/) {
+    if (!check_message_frame(data, len, JOIN_REQUEST_SIZE) || get_message_type(data) != join_request
+        || data->protocol < PROTOCOL_MIN_VERSION)
         return false;
 
-    if (dev_eui)
-        *dev_eui = data->dev_eui;
-
+    join_request_schema::ops::decode((const uint8_t *)data, 0, dev_eui, protocol, capabilities);
     return true;
 }
 
 /**
- * @brief Get a string representation for a join request message
-
+ * @brief Write a string representation for a join request message
  * @param jr A pointer to the join request message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
  * @param pretty True == print a verbose version, false == just the field values
- * @return The string representation, a pointer to static memory. Overwritten
- * on subsequent calls.
+ * @return The number of characters written, not counting the null.
  */
-char *join_request_to_string(const join_request_t *jr, bool pretty /*false*/) {
-    uint64_t dev_eui;
-
-    parse_join_request(jr, &dev_eui);
+size_t join_request_to_string(const join_request_t *jr, char *buf, size_t len, bool pretty /*false*/) {
+    uint64_t dev_eui = jr->dev_eui;
+    uint8_t protocol = jr->protocol;
+    uint8_t capabilities = jr->capabilities;
 
-    static char decoded_string[64];
+    int n;
     if (pretty) {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "type: %s, device EUI: 0x%16llx",
-                 get_message_type_string(get_message_type((void*)jr)), dev_eui);
+        n = snprintf(buf, len, "type: %s, device EUI: 0x%16llx, protocol: %u, capabilities: %02x",
+                     get_message_type_string(get_message_type((void*)jr)), (unsigned long long)dev_eui,
+                     protocol, capabilities);
     } else {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "%s, 0x%16llx",
-                 get_message_type_string(get_message_type((void*)jr)), dev_eui);
+        n = snprintf(buf, len, "%s, 0x%16llx, %u, %02x",
+                     get_message_type_string(get_message_type((void*)jr)), (unsigned long long)dev_eui,
+                     protocol, capabilities);
     }
 
-    return decoded_string;
+    return written_length(n, len);
 }
+
 ///@}
 
 /** @name Join response */
@@ -113,43 +228,130 @@ char *join_request_to_string(const join_request_t *jr, bool pretty /*false*/) {
  * to the requesting node and returning that node number and the current time.
  * The requester updates its node number and time.
  *
+ * The response is addressed to the leaf being assigned, so leaf_node
+ * (the 'to' field) is always the same as node.
+ *
  * @param jr The join Response message
  * @param node The node number
  * @param time The time
+ * @param slot The node's transmit slot; null == no schedule
+ * @param encoding The message type the node should send readings as,
+ * e.g., from choose_data_encoding()
  */
-void build_join_response(join_response_t *jr, uint8_t node, uint32_t time) {
-    jr->type = join_response;
-    jr->node = node;
-    jr->time = time;
+void build_join_response(join_response_t *jr, uint8_t node, uint32_t time, const tx_slot_t *slot /*0*/,
+                         MessageType encoding /*data_packet*/) {
+    tx_slot_t none = {0, 0, 0};
+    if (!slot)
+        slot = &none;
+
+    join_response_schema::ops::encode((uint8_t *)jr, join_response, node, node, time, slot->slot,
+                                      slot->slot_length, slot->frame_length, PROTOCOL_VERSION, encoding);
 }
 
-
-bool parse_join_response(const join_response_t *data, uint8_t *node, uint32_t *time) {
-    if (data->type != join_request)
+/**
+ * @brief extract information from a join_response message
+ * @param data The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the node number assigned to the leaf
+ * @param time If not null, returns the time
+ * @param slot If not null, returns the leaf's transmit slot
+ * @param encoding If not null, returns the message type to send readings as
+ * @return true if this is a join_response message, false otherwise.
+ */
+bool parse_join_response(const join_response_t *data, uint8_t len, uint8_t *node, uint32_t *time,
+                         tx_slot_t *slot /*0*/, MessageType *encoding /*0*/) {
+    if (!check_message_frame(data, len, JOIN_RESPONSE_SIZE) || get_message_type(data) != join_response)
         return false;
 
-    if (node)
-        *node = data->node;
-    if (time)
-        *time = data->time;
-
+    join_response_schema::ops::decode((const uint8_t *)data, 0, node, 0, time, slot ? &slot->slot : 0,
+                                      slot ? &slot->slot_length : 0, slot ? &slot->frame_length : 0, 0,
+                                      encoding);
     return true;
 }
 
-char *join_response_to_string(const join_response_t *jr, bool pretty /*false*/) {
-    uint8_t node;
-    uint32_t time;
+/**
+ * @brief Write a string representation for a join response message
+ * @param jr A pointer to the join response message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t join_response_to_string(const join_response_t *jr, char *buf, size_t len, bool pretty /*false*/) {
+    if (!pretty)
+        return format_fields<join_response_schema::csv>(jr, buf, len);
+
+    int n = snprintf(buf, len, "node: %u, time: %lu, slot: %u (%u s), frame: %u s, encoding: %s", jr->node,
+                     (unsigned long)jr->time, jr->slot, jr->slot_length, jr->frame_length,
+                     get_message_type_string(jr->encoding));
 
-    parse_join_response(jr, &node, &time);
+    return written_length(n, len);
+}
 
-    static char decoded_string[64];
-    if (pretty) {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "node: %u, time: %lu", node, time);
-    } else {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "%u, %lu", node, time);
+/** @name Mean bytes per reading
+ * Measured on the sample readings in extras/benchmark.
+ */
+///@{
+#define DELTA_MEAN_SIZE 12      // keyframes included
+#define PACKED_MEAN_SIZE 17     // the default packed_format_t
+///@}
+
+/**
+ * @brief Pick the encoding that takes the least airtime per reading
+ *
+ * Each encoding the leaf and this main node share is rated by the time
+ * on air of the frames it sends, preamble and headers included, divided
+ * by the readings in them (see airtime.h):
+ *  - data_delta: one reading of about 12 bytes per frame
+ *  - data_batch: batch_depth readings of 12 bytes and an 11 byte header
+ *  - data_packed: one 17 byte reading per frame
+ *  - data_packet: one 20 byte reading per frame; every node can send it
+ *
+ * Since every frame pays for its preamble, a batch of a few readings
+ * usually beats the smallest single-reading encoding; a batch of one
+ * does not. On a tie the encoding higher in the list wins.
+ *
+ * @param capabilities The leaf's CAPABILITY_* bits, from its join request
+ * @param supported The encodings this main node takes
+ * @param batch_depth Readings per data_batch the leaf will be told to
+ * send (see config_t); 0 == DATA_BATCH_MAX_READINGS
+ * @param spreading_factor The leaf's spreading factor
+ * @param bandwidth The channel's bandwidth, Hz
+ * @return The message type the leaf should send its readings as
+ */
+MessageType choose_data_encoding(uint8_t capabilities, uint8_t supported /*PROTOCOL_CAPABILITIES*/,
+                                 uint8_t batch_depth /*0*/, uint8_t spreading_factor /*LORA_DEFAULT_SF*/,
+                                 uint32_t bandwidth /*LORA_DEFAULT_BANDWIDTH*/) {
+    uint8_t both = capabilities & supported;
+    if (batch_depth == 0 || batch_depth > DATA_BATCH_MAX_READINGS)
+        batch_depth = DATA_BATCH_MAX_READINGS;
+
+    MessageType best = data_packet;
+    uint32_t best_us = lora_airtime_us(DATA_PACKET_SIZE, spreading_factor, bandwidth);
+
+    // From the least compact up, so that a tie goes to the later one
+    if (both & CAPABILITY_PACKED) {
+        uint32_t us = lora_airtime_us(PACKED_MEAN_SIZE, spreading_factor, bandwidth);
+        if (us <= best_us) {
+            best = data_packed;
+            best_us = us;
+        }
+    }
+    if (both & CAPABILITY_BATCH) {
+        uint8_t len = (uint8_t)(DATA_BATCH_HEADER_SIZE + batch_depth * sizeof(batch_reading_t));
+        uint32_t us = lora_airtime_us(len, spreading_factor, bandwidth) / batch_depth;
+        if (us <= best_us) {
+            best = data_batch;
+            best_us = us;
+        }
+    }
+    if (both & CAPABILITY_DELTA) {
+        uint32_t us = lora_airtime_us(DELTA_MEAN_SIZE, spreading_factor, bandwidth);
+        if (us <= best_us)
+            best = data_delta;
     }
 
-    return decoded_string;
+    return best;
 }
 ///@}
 
@@ -161,49 +363,47 @@ char *join_response_to_string(const join_response_t *jr, bool pretty /*false*/)
  * @param node The node making the request
  */
 void build_time_request(time_request_t *tr, uint8_t node) {
-    tr->type = time_request;
-    tr->node = node;
+    time_request_schema::ops::encode((uint8_t *)tr, time_request, node);
 }
 
 /**
  * @brief extract information from a time_request message
+ * @param data The received message
+ * @param len The number of bytes received, including any CRC trailer
  * @param node If not null, returns the node number of the requesting leaf node
  * @return true is this is a time_request message, false otherwise.
  */
-bool parse_time_request(const time_request_t *data, uint8_t *node) {
-    if (data->type != time_request)
+bool parse_time_request(const time_request_t *data, uint8_t len, uint8_t *node) {
+    if (!check_message_frame(data, len, TIME_REQUEST_SIZE) || get_message_type(data) != time_request)
         return false;
 
-    if (node)
-        *node = data->node;
-
+    time_request_schema::ops::decode((const uint8_t *)data, 0, node);
     return true;
 }
 
 /**
- * @brief Get a string representation for a time request message
-
+ * @brief Write a string representation for a time request message
  * @param tr A pointer to the time request message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
  * @param pretty True == print a verbose version, false == just the field values
- * @return The string representation, a pointer to static memory. Overwritten
- * on subsequent calls.
+ * @return The number of characters written, not counting the null.
  */
-char *time_request_to_string(const time_request_t *tr, bool pretty /*false*/) {
-    uint8_t node;
-
-    parse_time_request(tr, &node);
+size_t time_request_to_string(const time_request_t *tr, char *buf, size_t len, bool pretty /*false*/) {
+    uint8_t node = tr->node;
 
-    static char decoded_string[64];
+    int n;
     if (pretty) {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "type: %s, Node: %d",
-                 get_message_type_string(get_message_type((void*)tr)), node);
+        n = snprintf(buf, len, "type: %s, Node: %d",
+                     get_message_type_string(get_message_type((void*)tr)), node);
     } else {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "%s, %d",
-                 get_message_type_string(get_message_type((void*)tr)), node);
+        n = snprintf(buf, len, "%s, %d",
+                     get_message_type_string(get_message_type((void*)tr)), node);
     }
 
-    return decoded_string;
+    return written_length(n, len);
 }
+
 ///@}
 
 /** @name Time response */
@@ -217,39 +417,109 @@ char *time_request_to_string(const time_request_t *tr, bool pretty /*false*/) {
  * @param tr The Time Response message
  * @param node The node number
  * @param time The time
+ * @param slot The node's transmit slot; null == no schedule
  */
-void build_time_response(time_response_t *jr, uint8_t node, uint32_t time) {
-    jr->type = time_response;
-    jr->node = node;
-    jr->time = time;
+void build_time_response(time_response_t *jr, uint8_t node, uint32_t time, const tx_slot_t *slot /*0*/) {
+    tx_slot_t none = {0, 0, 0};
+    if (!slot)
+        slot = &none;
+
+    time_response_schema::ops::encode((uint8_t *)jr, time_response, node, time, slot->slot, slot->slot_length,
+                                      slot->frame_length);
 }
 
-bool parse_time_response(const time_response_t *data, uint8_t *node, uint32_t *time) {
-    if (data->type != time_response)
+/**
+ * @brief extract information from a time_response message
+ * @param data The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the node number
+ * @param time If not null, returns the time
+ * @param slot If not null, returns the node's transmit slot
+ * @return true if this is a time_response message, false otherwise.
+ */
+bool parse_time_response(const time_response_t *data, uint8_t len, uint8_t *node, uint32_t *time,
+                         tx_slot_t *slot /*0*/) {
+    if (!check_message_frame(data, len, TIME_RESPONSE_SIZE) || get_message_type(data) != time_response)
         return false;
 
-    if (node)
-        *node = data->node;
-    if (time)
-        *time = data->time;
-
+    time_response_schema::ops::decode((const uint8_t *)data, 0, node, time, slot ? &slot->slot : 0,
+                                      slot ? &slot->slot_length : 0, slot ? &slot->frame_length : 0);
     return true;
 }
 
-char *time_response_to_string(const time_response_t *tr, bool pretty /*false*/) {
-    uint8_t node;
-    uint32_t time;
+/**
+ * @brief Write a string representation for a time response message
+ * @param tr A pointer to the time response message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t time_response_to_string(const time_response_t *tr, char *buf, size_t len, bool pretty /*false*/) {
+    if (!pretty)
+        return format_fields<time_response_schema::csv>(tr, buf, len);
 
-    parse_time_response(tr, &node, &time);
+    int n = snprintf(buf, len, "node: %u, time: %lu, slot: %u (%u s), frame: %u s", tr->node,
+                     (unsigned long)tr->time, tr->slot, tr->slot_length, tr->frame_length);
 
-    static char decoded_string[64];
-    if (pretty) {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "node: %u, time: %lu", node, time);
-    } else {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "%u, %lu", node, time);
-    }
+    return written_length(n, len);
+}
+
+///@}
 
-    return decoded_string;
+/** @name Config */
+///@{
+
+/**
+ * @brief Build a Config message
+ *
+ * The main node sends this to change how a leaf node reports. Pass 0
+ * for any setting that should be left as it is.
+ *
+ * @param c The Config message
+ * @param node The node number of the leaf node
+ * @param interval Seconds between readings
+ * @param spreading_factor LoRa spreading factor, 7 - 12
+ * @param tx_power Transmit power in dBm
+ * @param batch_depth Readings to send in each batch
+ */
+void build_config(config_t *c, uint8_t node, uint16_t interval, uint8_t spreading_factor, int8_t tx_power,
+                  uint8_t batch_depth) {
+    config_schema::ops::encode((uint8_t *)c, config, node, interval, spreading_factor, tx_power, batch_depth);
+}
+
+/**
+ * @brief extract information from a config message
+ * Each V-R parameter may be null.
+ * @param data The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @return true is this is a config message, false otherwise.
+ */
+bool parse_config(const config_t *data, uint8_t len, uint8_t *node, uint16_t *interval, uint8_t *spreading_factor,
+                  int8_t *tx_power, uint8_t *batch_depth) {
+    if (!check_message_frame(data, len, CONFIG_SIZE) || get_message_type(data) != config)
+        return false;
+
+    config_schema::ops::decode((const uint8_t *)data, 0, node, interval, spreading_factor, tx_power, batch_depth);
+    return true;
+}
+
+/**
+ * @brief Write a string representation for a config message
+ * @param c A pointer to the config message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t config_to_string(const config_t *c, char *buf, size_t len, bool pretty /*false*/) {
+    if (!pretty)
+        return format_fields<config_schema::csv>(c, buf, len);
+
+    int n = snprintf(buf, len, "node: %u, interval: %u s, SF: %u, Tx power: %d dBm, batch: %u",
+                     c->node, c->interval, c->spreading_factor, c->tx_power, c->batch_depth);
+
+    return written_length(n, len);
 }
 ///@}
 
@@ -259,7 +529,9 @@ char *time_response_to_string(const time_response_t *tr, bool pretty /*false*/)
 /**
  * @brief Build a Text message
  *
- * Either the main or leaf node can send a Text message.
+ * Either the main or leaf node can send a Text message. Text longer than
+ * TEXT_BUF_LEN is cut to fit; send longer text as fragments (see
+ * fragment.h).
  *
  * @param t The Text message
  * @param node The node number
@@ -268,39 +540,67 @@ char *time_response_to_string(const time_response_t *tr, bool pretty /*false*/)
  */
 
 void build_text_message(text_t *t, const uint8_t node, const uint8_t length, const uint8_t *buf /* TEXT_BUF_LEN */) {
-    t->type = text;
-    t->node = node;
-    t->length = length;
-    memcpy(t->buf, buf, (length < TEXT_BUF_LEN) ? length: TEXT_BUF_LEN);
+    const uint8_t n = (length < TEXT_BUF_LEN) ? length : TEXT_BUF_LEN;
+    text_schema::ops::encode((uint8_t *)t, text, node, n);
+    memcpy(t->buf, buf, n);
 }
 
-bool parse_text_message(const text_t *data, uint8_t *node, uint8_t *length, uint8_t *buf) {
-    if (data->type != text)
+/**
+ * @brief extract information from a text message
+ * @param data The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the node number
+ * @param length If not null, returns the number of characters
+ * @param buf If not null (and length is not), returns the characters
+ * @return true if this is a whole text message, false otherwise.
+ */
+bool parse_text_message(const text_t *data, uint8_t len, uint8_t *node, uint8_t *length, uint8_t *buf) {
+    const size_t header = text_schema::ops::size;
+    if (len < header || get_message_type(data) != text)
+        return false;
+
+    uint8_t n;
+    text_schema::ops::decode((const uint8_t *)data, 0, node, &n);
+    if (n > TEXT_BUF_LEN || !check_message_frame(data, len, header + n))
         return false;
 
-    if (node)
-        *node = data->node;
     if (length)
-        *length = data->length;
+        *length = n;
     if (length && buf)
-        memcpy(buf, data->buf, (*length < TEXT_BUF_LEN) ? *length: TEXT_BUF_LEN);
+        memcpy(buf, data->buf, n);
 
     return true;
 }
 
-char *text_message_to_string(const text_t *t, bool pretty /*false*/) {
-    uint8_t node;
-    uint8_t length;
-    uint8_t msg[TEXT_BUF_LEN+1];
-
-    parse_text_message(t, &node, &length, msg);
+/**
+ * @brief Write a string representation for a text message
+ *
+ * The text is copied straight from the message; it does not need to be
+ * null terminated.
+ *
+ * @param t A pointer to the text message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t text_message_to_string(const text_t *t, char *buf, size_t len, bool pretty /*false*/) {
+    size_t length = (t->length < TEXT_BUF_LEN) ? t->length : TEXT_BUF_LEN;
 
-    static char decoded_string[TEXT_BUF_LEN + 20];
     if (pretty) {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "node: %u, message: %s", node, t->buf);
-    } else {
-        snprintf((char *)decoded_string, sizeof(decoded_string), "%u, %s", node, t->buf);
+        int n = snprintf(buf, len, "node: %u, message: %.*s", t->node, (int)length, (const char *)t->buf);
+        return written_length(n, len);
     }
 
-    return decoded_string;
-}
\ No newline at end of file
+    // The header fields, then as much of ", " and the text as fits
+    char *p = buf + format_fields<text_schema::csv>(t, buf, len);
+    const char *end = buf + (len ? len - 1 : 0);
+    for (const char *sep = ", "; *sep && p < end; ++sep)
+        *p++ = *sep;
+    for (size_t i = 0; i < length && p < end; ++i)
+        *p++ = (char)t->buf[i];
+    if (len)
+        *p = '\0';
+
+    return p - buf;
+}
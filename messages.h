@@ -10,21 +10,75 @@
 #include <Arduino.h>
 #include <RH_RF95.h>
 
+#include "wire_format.h"
+#include "airtime.h"
+
 /** 
  * Message types the leaf node may send to the main node.
+ *
+ * @note The type is sent as a single byte, the first byte of every
+ * message.
  */
-enum MessageType {
+enum MessageType : uint8_t {
     join_request = 1,
     join_response = 2,
     time_request = 3,
     time_response = 4,
     // error = 5,
+    ack_bitmap = 6,
+    config = 7,
 
     // the main node only provides the ACK for these messages
     data_packet = 10,
     text = 11,
+    data_delta = 12,
+    data_batch = 13,
+    timing_report = 14,
+    stats = 15,
+    data_packed = 16,
+    data_sensors = 17,
+    data_summary = 18,
+    fragment = 19,
+    fragment_nack = 20,
 };
 
+/**
+ * The version of the wire format in this library, sent in the join
+ * request and join response.
+ *
+ * Version 1 is the first versioned format. It differs from the layouts
+ * before it in every message (packed structs, a one-byte type, the CRC
+ * flag), so nodes from before version 1 cannot talk to nodes with this
+ * library; update the main and leaf nodes together. From version 1 on,
+ * a new version may only add fields to the end of a message.
+ */
+#define PROTOCOL_VERSION 1
+
+/**
+ * The oldest protocol version a main node answers a join request from.
+ * A newer leaf is answered; the join response carries PROTOCOL_VERSION
+ * and, since later versions only add fields, the leaf can fall back to
+ * it.
+ */
+#define PROTOCOL_MIN_VERSION 1
+
+/** @name Capability bits
+ * The optional encodings a leaf node can send, in join_request_t.
+ * Every node can send data_packet.
+ */
+///@{
+#define CAPABILITY_DELTA 0x01       // data_delta
+#define CAPABILITY_BATCH 0x02       // data_batch
+#define CAPABILITY_PACKED 0x04      // data_packed
+#define CAPABILITY_SENSORS 0x08     // data_sensors
+#define CAPABILITY_SUMMARY 0x10     // data_summary
+#define CAPABILITY_FRAGMENT 0x20    // fragment and fragment_nack
+#define CAPABILITY_CRC 0x40         // the CRC trailer
+///@}
+
+/// Everything this library can send and receive
+#define PROTOCOL_CAPABILITIES 0x7f
+
 /// Size of the join request in bytes
 #define JOIN_REQUEST_SIZE sizeof(join_request_t)
 
@@ -33,6 +87,10 @@ enum MessageType {
  * its EUI - a kind of UUID. The response from the main nide is a
  * join_response_t.
  *
+ * It also says which version of the wire format the leaf speaks and
+ * which of the optional encodings it can send, so the main node can
+ * pick the most compact one for it.
+ *
  * @note there is no node number in this request because this is
  * the request a new node makes to get that 8-bit number bound to
  * its 64-bit EUI.
@@ -40,6 +98,24 @@ enum MessageType {
 struct join_request_t {
     MessageType type; // join_request
     uint64_t dev_eui; // read from the RS EUI chip
+    uint8_t protocol;       // PROTOCOL_VERSION
+    uint8_t capabilities;   // CAPABILITY_* bits
+} PACKED;
+
+static_assert(JOIN_REQUEST_SIZE == 11, "join_request_t wire layout changed");
+
+/**
+ * A leaf node's transmit slot. Time is divided into frames of
+ * frame_length seconds, starting when the Unix time is a multiple of
+ * frame_length, and each frame into slots of slot_length seconds. A
+ * leaf transmits only at the start of its own slot (see slot_schedule.h).
+ * A frame_length of 0 means there is no schedule and the leaf sends
+ * when it likes.
+ */
+struct tx_slot_t {
+    uint8_t slot;           // slot number within the frame
+    uint8_t slot_length;    // seconds, including guard time
+    uint16_t frame_length;  // seconds
 };
 
 /// Size of the join response in bytes
@@ -50,16 +126,24 @@ struct join_request_t {
  * should use in all subsequent messages and the time. The main node
  * maintains a table mapping EUIs to leaf_ node numbers.  The leaf
  * node records the node number and sets its time (so it will be
- * synchronized with the main node).
+ * synchronized with the main node). It also gets its transmit slot, and
+ * the encoding it should send its readings with.
  *
  * @todo Add EUI to the response
  */
 struct join_response_t {
     MessageType type;
     uint8_t node;       // From
-    uint8_t leaf_node;  // TO
+    uint8_t leaf_node;  // TO; the same as node, set by build_join_response()
     uint32_t time;
-};
+    uint8_t slot;           // see tx_slot_t
+    uint8_t slot_length;
+    uint16_t frame_length;
+    uint8_t protocol;       // PROTOCOL_VERSION
+    MessageType encoding;   // for readings; see choose_data_encoding()
+} PACKED;
+
+static_assert(JOIN_RESPONSE_SIZE == 13, "join_response_t wire layout changed");
 
 /// Size of the time request in bytes
 #define TIME_REQUEST_SIZE sizeof(time_request_t)
@@ -70,49 +154,109 @@ struct join_response_t {
 struct time_request_t {
     MessageType type;
     uint8_t node; // From
-};
+} PACKED;
 
-/// Size of the time request in bytes
+static_assert(TIME_REQUEST_SIZE == 2, "time_request_t wire layout changed");
+
+/// Size of the time response in bytes
 #define TIME_RESPONSE_SIZE sizeof(time_response_t)
 
 /**
- * The time from the main node.
+ * The time from the main node, and the leaf's transmit slot so that a
+ * schedule change reaches the leaf the next time it syncs.
  */
 struct time_response_t {
     MessageType type;
     uint8_t node;       // From
     uint32_t time;      // Unix time
-};
+    uint8_t slot;           // see tx_slot_t
+    uint8_t slot_length;
+    uint16_t frame_length;
+} PACKED;
+
+static_assert(TIME_RESPONSE_SIZE == 10, "time_response_t wire layout changed");
+
+/// Size of the config message in bytes
+#define CONFIG_SIZE sizeof(config_t)
+
+/**
+ * Settings the main node pushes to a leaf node: how often to report,
+ * the radio's spreading factor and transmit power, and how many readings
+ * to put in each batch. A field that is zero is left unchanged.
+ */
+struct config_t {
+    MessageType type;
+    uint8_t node;               // TO
+    uint16_t interval;          // seconds between readings
+    uint8_t spreading_factor;   // 7 - 12
+    int8_t tx_power;            // dBm
+    uint8_t batch_depth;        // readings per data_batch
+} PACKED;
+
+static_assert(CONFIG_SIZE == 7, "config_t wire layout changed");
 
 #define TEXT_BUF_LEN (RH_RF95_MAX_MESSAGE_LEN - sizeof(MessageType) - sizeof(uint8_t) - sizeof(uint8_t))
 
+/// Size of the largest text message in bytes
+#define TEXT_SIZE sizeof(text_t)
+
+/**
+ * A text message. Only the first 3 + length bytes need to be sent.
+ */
 struct text_t {
     MessageType type;
-    uint32_t node;      // From
+    uint8_t node;       // From
     uint8_t length;     // Number of chars in buf
     uint8_t buf[TEXT_BUF_LEN];
-};
+} PACKED;
 
-MessageType get_message_type(void *message);
+static_assert(TEXT_SIZE == RH_RF95_MAX_MESSAGE_LEN, "text_t must fill exactly one radio frame");
+
+/// Set in the type byte of a message that ends with a CRC-16 trailer
+#define MESSAGE_CRC_FLAG 0x80
+
+/// Size of the CRC trailer in bytes
+#define MESSAGE_CRC_SIZE 2
+
+MessageType get_message_type(const void *message);
 char *get_message_type_string(MessageType type);
 
-void build_join_request(join_request_t *jr, uint64_t dev_eui);
-bool parse_join_request(const join_request_t *data, uint64_t *dev_eui);
-char *join_request_to_string(const join_request_t *jr, bool pretty /*false*/);
+bool message_has_crc(const void *message);
+size_t add_message_crc(void *message, size_t len, size_t size);
+bool check_message_crc(const void *message, size_t len);
+bool check_message_frame(const void *message, size_t len, size_t size);
 
-char *join_response_to_string(const join_response_t *jr, bool pretty /*false*/);
-bool parse_join_response(const join_response_t *data, uint8_t *node, uint32_t *time);
-void build_join_response(join_response_t *jr, uint8_t node, uint32_t time);
+void build_join_request(join_request_t *jr, uint64_t dev_eui, uint8_t capabilities = PROTOCOL_CAPABILITIES);
+bool parse_join_request(const join_request_t *data, uint8_t len, uint64_t *dev_eui, uint8_t *protocol = 0,
+                        uint8_t *capabilities = 0);
+size_t join_request_to_string(const join_request_t *jr, char *buf, size_t len, bool pretty = false);
 
-char *time_request_to_string(const time_request_t *tr, bool pretty /*false*/);
-bool parse_time_request(const time_request_t *data, uint8_t *node);
+size_t join_response_to_string(const join_response_t *jr, char *buf, size_t len, bool pretty = false);
+bool parse_join_response(const join_response_t *data, uint8_t len, uint8_t *node, uint32_t *time,
+                         tx_slot_t *slot = 0, MessageType *encoding = 0);
+void build_join_response(join_response_t *jr, uint8_t node, uint32_t time, const tx_slot_t *slot = 0,
+                         MessageType encoding = data_packet);
+MessageType choose_data_encoding(uint8_t capabilities, uint8_t supported = PROTOCOL_CAPABILITIES,
+                                 uint8_t batch_depth = 0, uint8_t spreading_factor = LORA_DEFAULT_SF,
+                                 uint32_t bandwidth = LORA_DEFAULT_BANDWIDTH);
+
+size_t time_request_to_string(const time_request_t *tr, char *buf, size_t len, bool pretty = false);
+bool parse_time_request(const time_request_t *data, uint8_t len, uint8_t *node);
 void build_time_request(time_request_t *tr, uint8_t node);
 
-char *time_response_to_string(const time_response_t *tr, bool pretty /*false*/);
-bool parse_time_response(const time_response_t *data, uint8_t *node, uint32_t *time);
-void build_time_response(time_response_t *jr, uint8_t node, uint32_t time);
+size_t time_response_to_string(const time_response_t *tr, char *buf, size_t len, bool pretty = false);
+bool parse_time_response(const time_response_t *data, uint8_t len, uint8_t *node, uint32_t *time,
+                         tx_slot_t *slot = 0);
+void build_time_response(time_response_t *jr, uint8_t node, uint32_t time, const tx_slot_t *slot = 0);
+
+size_t config_to_string(const config_t *c, char *buf, size_t len, bool pretty = false);
+bool parse_config(const config_t *data, uint8_t len, uint8_t *node, uint16_t *interval, uint8_t *spreading_factor,
+                  int8_t *tx_power, uint8_t *batch_depth);
+void build_config(config_t *c, uint8_t node, uint16_t interval, uint8_t spreading_factor, int8_t tx_power,
+                  uint8_t batch_depth);
 
-char *text_message_to_string(const text_t *t, bool pretty /*false*/);
-bool parse_text_message(const text_t *data, uint8_t *node, uint8_t *length, uint8_t **buf);
+size_t text_message_to_string(const text_t *t, char *buf, size_t len, bool pretty = false);
+bool parse_text_message(const text_t *data, uint8_t len, uint8_t *node, uint8_t *length,
+                        uint8_t *buf /* TEXT_BUF_LEN */);
 void build_text_message(text_t *t, const uint8_t node, const uint8_t length, const uint8_t *buf /* TEXT_BUF_LEN */);
 #endif
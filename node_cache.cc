@@ -0,0 +1,61 @@
+// Leaf node cache of its assigned node number.
+
+#include <Arduino.h>
+
+#include "node_cache.h"
+#include "crc16.h"
+
+/**
+ * @brief Save the node number from a join response
+ * @param storage The storage device
+ * @param address Where to write the cache
+ * @param dev_eui This leaf's EUI
+ * @param node The node number assigned by the main node
+ * @return true if the cache was written, false otherwise.
+ */
+bool save_node_cache(const storage_t *storage, uint32_t address, uint64_t dev_eui, uint8_t node) {
+    node_cache_t cache;
+    cache.magic = NODE_CACHE_MAGIC;
+    cache.version = NODE_CACHE_VERSION;
+    cache.node = node;
+    cache.dev_eui = dev_eui;
+    cache.crc = crc16((const uint8_t *)&cache, offsetof(node_cache_t, crc));
+
+    return storage->write(address, &cache, sizeof(cache), storage->context);
+}
+
+/**
+ * @brief Get the saved node number
+ * @param storage The storage device
+ * @param address Where the cache was written
+ * @param dev_eui This leaf's EUI; a cache saved for another EUI is ignored
+ * @param node V-R parameter for the node number
+ * @return true if there is a valid cache for this EUI, false if the
+ * leaf must join.
+ */
+bool load_node_cache(const storage_t *storage, uint32_t address, uint64_t dev_eui, uint8_t *node) {
+    node_cache_t cache;
+    if (!storage->read(address, &cache, sizeof(cache), storage->context))
+        return false;
+
+    if (cache.magic != NODE_CACHE_MAGIC || cache.version != NODE_CACHE_VERSION
+        || cache.crc != crc16((const uint8_t *)&cache, offsetof(node_cache_t, crc))
+        || cache.dev_eui != dev_eui || cache.node == 0)
+        return false;
+
+    *node = cache.node;
+    return true;
+}
+
+/**
+ * @brief Forget the saved node number
+ * @param storage The storage device
+ * @param address Where the cache was written
+ * @return true if the cache was cleared, false otherwise.
+ */
+bool clear_node_cache(const storage_t *storage, uint32_t address) {
+    node_cache_t cache;
+    memset(&cache, 0, sizeof(cache));
+
+    return storage->write(address, &cache, sizeof(cache), storage->context);
+}
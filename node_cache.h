@@ -0,0 +1,33 @@
+/**
+ * The leaf node's copy of the node number the main node assigned it.
+ *
+ * A leaf that finds a saved assignment for its own EUI after a reset can
+ * go straight to sending data packets instead of sending a join request
+ * and waiting for the response. If the main node stops acknowledging
+ * its packets, the leaf should clear the cache and join again.
+ */
+
+#ifndef h_node_cache_h
+#define h_node_cache_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "storage.h"
+
+#define NODE_CACHE_MAGIC 0x434e4d53     // "SMNC"
+#define NODE_CACHE_VERSION 1
+
+struct node_cache_t {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t node;
+    uint64_t dev_eui;
+    uint16_t crc;       // CRC-16 of the preceding fields
+} PACKED;
+
+bool save_node_cache(const storage_t *storage, uint32_t address, uint64_t dev_eui, uint8_t node);
+bool load_node_cache(const storage_t *storage, uint32_t address, uint64_t dev_eui, uint8_t *node);
+bool clear_node_cache(const storage_t *storage, uint32_t address);
+
+#endif
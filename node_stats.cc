@@ -0,0 +1,158 @@
+// Build, parse and print the leaf node stats message.
+
+#include <Arduino.h>
+
+#include "node_stats.h"
+#include "varint.h"
+
+/**
+ * @brief Is it time to send a stats message?
+ * @param message The message number of the data packet just sent
+ * @param every Optional, send stats once every this many packets.
+ * Default: STATS_INTERVAL
+ * @return true if a stats message should follow this packet.
+ */
+bool stats_message_due(uint32_t message, uint8_t every /* STATS_INTERVAL */) {
+    return every && message % every == 0;
+}
+
+/**
+ * @brief Build a stats message
+ * @param buf Destination for the frame, at least STATS_MESSAGE_MAX_SIZE bytes
+ * @param node The node number of the sender
+ * @param stats The statistics
+ * @return The number of bytes in the frame.
+ */
+uint8_t build_stats_message(uint8_t *buf, uint8_t node, const node_stats_t *stats) {
+    uint8_t flags = 0;
+    uint8_t n = 3;
+
+    buf[0] = MessageType::stats;
+    buf[1] = node;
+
+    if (stats->packets) {
+        flags |= STATS_PACKETS;
+        n += put_varint(buf + n, stats->packets);
+    }
+    if (stats->retries) {
+        flags |= STATS_RETRIES;
+        n += put_varint(buf + n, stats->retries);
+    }
+    if (stats->ack_failures) {
+        flags |= STATS_ACK_FAILURES;
+        n += put_varint(buf + n, stats->ack_failures);
+    }
+    if (stats->ack_rssi) {
+        flags |= STATS_ACK_RSSI;
+        n += put_varint(buf + n, zigzag_encode(stats->ack_rssi));
+    }
+    if (stats->ack_snr) {
+        flags |= STATS_ACK_SNR;
+        n += put_varint(buf + n, zigzag_encode(stats->ack_snr));
+    }
+    if (stats->wake_ms) {
+        flags |= STATS_WAKE_MS;
+        n += put_varint(buf + n, stats->wake_ms);
+    }
+    if (stats->queue_depth) {
+        flags |= STATS_QUEUE_DEPTH;
+        n += put_varint(buf + n, stats->queue_depth);
+    }
+
+    buf[2] = flags;
+    return n;
+}
+
+/**
+ * @brief extract information from a stats message
+ * @param buf The frame
+ * @param len The number of bytes in the frame
+ * @param node If not null, returns the node number of the sender
+ * @param stats V-R parameter for the statistics
+ * @return true if this is a valid stats message, false otherwise.
+ */
+bool parse_stats_message(const uint8_t *buf, uint8_t len, uint8_t *node, node_stats_t *stats) {
+    if (len < 3 || get_message_type(buf) != MessageType::stats)
+        return false;
+
+    if (message_has_crc(buf)) {
+        if (len < 3 + MESSAGE_CRC_SIZE || !check_message_crc(buf, len - MESSAGE_CRC_SIZE))
+            return false;
+        len -= MESSAGE_CRC_SIZE;
+    }
+
+    node_stats_t s;
+    memset(&s, 0, sizeof(s));
+    uint8_t flags = buf[2];
+    uint8_t n = 3;
+    uint32_t v;
+
+    for (uint8_t bit = STATS_PACKETS; bit <= STATS_QUEUE_DEPTH; bit <<= 1) {
+        if (!(flags & bit))
+            continue;
+
+        uint8_t used = get_varint(buf + n, len - n, &v);
+        if (!used)
+            return false;
+        n += used;
+
+        switch (bit) {
+            case STATS_PACKETS:
+                s.packets = v;
+                break;
+            case STATS_RETRIES:
+                s.retries = v;
+                break;
+            case STATS_ACK_FAILURES:
+                s.ack_failures = v;
+                break;
+            case STATS_ACK_RSSI:
+                s.ack_rssi = (int16_t)zigzag_decode(v);
+                break;
+            case STATS_ACK_SNR:
+                s.ack_snr = (int8_t)zigzag_decode(v);
+                break;
+            case STATS_WAKE_MS:
+                s.wake_ms = v;
+                break;
+            case STATS_QUEUE_DEPTH:
+                s.queue_depth = (uint16_t)v;
+                break;
+        }
+    }
+
+    if (node)
+        *node = buf[1];
+    *stats = s;
+
+    return true;
+}
+
+/**
+ * @brief Write a string representation for a node's statistics
+ * @param node The node number
+ * @param stats The statistics, e.g., from parse_stats_message()
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t stats_message_to_string(const uint8_t node, const node_stats_t *stats, char *buf, size_t len,
+                               bool pretty /*false*/) {
+    int n;
+    if (pretty) {
+        n = snprintf(buf, len, "node: %u, packets: %lu, retries: %lu, ACK failures: %lu, ACK RSSI: %d dBm, "
+                     "ACK SNR: %d dB, awake: %lu ms, queued: %u",
+                     node, (unsigned long)stats->packets, (unsigned long)stats->retries,
+                     (unsigned long)stats->ack_failures, stats->ack_rssi, stats->ack_snr,
+                     (unsigned long)stats->wake_ms, stats->queue_depth);
+    }
+    else {
+        n = snprintf(buf, len, "%u, %lu, %lu, %lu, %d, %d, %lu, %u",
+                     node, (unsigned long)stats->packets, (unsigned long)stats->retries,
+                     (unsigned long)stats->ack_failures, stats->ack_rssi, stats->ack_snr,
+                     (unsigned long)stats->wake_ms, stats->queue_depth);
+    }
+
+    return written_length(n, len);
+}
@@ -0,0 +1,57 @@
+/**
+ * Leaf node health statistics and the stats message that carries them.
+ *
+ * The leaf keeps a node_stats_t up to date and sends it every
+ * STATS_INTERVAL data packets or so (see stats_message_due()), rather
+ * than paying for it in every packet.
+ *
+ * Frame layout:
+ *  byte 0: stats
+ *  byte 1: node
+ *  byte 2: one 'present' bit per field, STATS_PACKETS ... STATS_QUEUE_DEPTH
+ *  then each present field as a varint; ack_rssi and ack_snr zig-zag
+ *  mapped. Fields that are not present are zero.
+ */
+
+#ifndef h_node_stats_h
+#define h_node_stats_h
+
+#include <Arduino.h>
+
+#include "messages.h"
+
+/// Suggested number of data packets between stats messages
+#define STATS_INTERVAL 24
+
+/// The largest encoded stats frame in bytes
+#define STATS_MESSAGE_MAX_SIZE 32
+
+/** @name Stats frame flags */
+///@{
+#define STATS_PACKETS 0x01
+#define STATS_RETRIES 0x02
+#define STATS_ACK_FAILURES 0x04
+#define STATS_ACK_RSSI 0x08
+#define STATS_ACK_SNR 0x10
+#define STATS_WAKE_MS 0x20
+#define STATS_QUEUE_DEPTH 0x40
+///@}
+
+struct node_stats_t {
+    uint32_t packets;       // data packets sent since reset
+    uint32_t retries;       // retransmissions since reset
+    uint32_t ack_failures;  // packets never acknowledged
+    int16_t ack_rssi;       // dBm, RSSI of the last ACK
+    int8_t ack_snr;         // dB, SNR of the last ACK
+    uint32_t wake_ms;       // time awake in the last reporting interval
+    uint16_t queue_depth;   // packets waiting to be sent
+};
+
+bool stats_message_due(uint32_t message, uint8_t every = STATS_INTERVAL);
+
+uint8_t build_stats_message(uint8_t *buf /* STATS_MESSAGE_MAX_SIZE */, uint8_t node, const node_stats_t *stats);
+bool parse_stats_message(const uint8_t *buf, uint8_t len, uint8_t *node, node_stats_t *stats);
+size_t stats_message_to_string(const uint8_t node, const node_stats_t *stats, char *buf, size_t len,
+                               bool pretty = false);
+
+#endif
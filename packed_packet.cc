@@ -0,0 +1,146 @@
+// Bit-packed data packet encode and decode functions.
+
+#include <Arduino.h>
+
+#include "packed_packet.h"
+#include "bit_pack.h"
+
+const packed_format_t default_packed_format = {
+    {250, 1, 8},        // battery, V x 100
+    {0, 8, 11},         // last_tx_duration, ms
+    {-4000, 10, 11},    // temp, C x 100
+    {0, 10, 10},        // humidity, % x 100
+};
+
+/**
+ * @brief Check that a packed field can be used
+ * @param field The field
+ * @return true if step is not 0 and bits is 1 - 16, false otherwise
+ */
+bool packed_field_valid(const packed_field_t *field) {
+    return field->step != 0 && field->bits >= 1 && field->bits <= 16;
+}
+
+/**
+ * @brief Check every field of a packed format
+ * @param format The packed format
+ * @return true if every field is valid, false otherwise
+ */
+bool packed_format_valid(const packed_format_t *format) {
+    return packed_field_valid(&format->battery) && packed_field_valid(&format->last_tx_duration)
+           && packed_field_valid(&format->temp) && packed_field_valid(&format->humidity);
+}
+
+/**
+ * @brief Scale a value for a packed field
+ * @param value The value, in packet_t units
+ * @param field The field
+ * @return The code to send, 0 to 2^bits - 1; 0 if the field is not valid
+ */
+uint32_t pack_fixed(int32_t value, const packed_field_t *field) {
+    if (!packed_field_valid(field))
+        return 0;
+
+    uint32_t max = (1ul << field->bits) - 1;
+    if (value <= field->offset)
+        return 0;
+
+    uint32_t code = ((uint32_t)(value - field->offset) + field->step / 2) / field->step;
+    return code > max ? max : code;
+}
+
+/**
+ * @brief The value of a packed field
+ * @param code The value sent
+ * @param field The field
+ * @return The value in packet_t units
+ */
+int32_t unpack_fixed(uint32_t code, const packed_field_t *field) {
+    return field->offset + (int32_t)(code * field->step);
+}
+
+/**
+ * @brief The size of a data_packed frame
+ * @param format The packed format
+ * @return The number of bytes build_packed_packet() writes, not counting
+ * a CRC trailer; 0 if the format is not valid
+ */
+uint8_t packed_packet_size(const packed_format_t *format) {
+    if (!packed_format_valid(format))
+        return 0;
+
+    uint16_t bits = format->battery.bits + format->last_tx_duration.bits + format->temp.bits
+                    + format->humidity.bits;
+    return (uint8_t)(PACKED_PACKET_HEADER_SIZE + BIT_PACK_BYTES(bits));
+}
+
+/**
+ * @brief Encode a data packet
+ * @param buf Destination, at least PACKED_PACKET_MAX_SIZE bytes
+ * @param data The packet
+ * @param format The packed format
+ * @return The number of bytes written; 0 if the format is not valid
+ */
+uint8_t build_packed_packet(uint8_t *buf, const packet_t *data, const packed_format_t *format /* default */) {
+    if (!packed_format_valid(format))
+        return 0;
+
+    buf[0] = data_packed;
+    buf[1] = data->node;
+    memcpy(buf + 2, &data->message, sizeof(uint32_t));
+    memcpy(buf + 6, &data->time, sizeof(uint32_t));
+    buf[10] = data->status;
+    buf[11] = data->data;
+
+    bit_writer_t w;
+    init_bit_writer(&w, buf + PACKED_PACKET_HEADER_SIZE);
+    put_bits(&w, pack_fixed(data->battery, &format->battery), format->battery.bits);
+    put_bits(&w, pack_fixed(data->last_tx_duration, &format->last_tx_duration), format->last_tx_duration.bits);
+    put_bits(&w, pack_fixed(data->temp, &format->temp), format->temp.bits);
+    put_bits(&w, pack_fixed(data->humidity, &format->humidity), format->humidity.bits);
+
+    return (uint8_t)(PACKED_PACKET_HEADER_SIZE + BIT_PACK_BYTES(w.bit));
+}
+
+/**
+ * @brief Decode a data_packed frame
+ * @param buf The frame
+ * @param len The number of bytes in the frame
+ * @param data V-R parameter for the decoded packet
+ * @param format The packed format the frame was built with
+ * @return true if the frame was decoded, false if it is not a
+ * data_packed frame, fails its CRC check, is too short for the format or
+ * the format is not valid.
+ */
+bool parse_packed_packet(const uint8_t *buf, uint8_t len, packet_t *data,
+                         const packed_format_t *format /* default */) {
+    if (!packed_format_valid(format) || len < PACKED_PACKET_HEADER_SIZE || get_message_type(buf) != data_packed)
+        return false;
+
+    if (message_has_crc(buf)) {
+        if (len < PACKED_PACKET_HEADER_SIZE + MESSAGE_CRC_SIZE || !check_message_crc(buf, len - MESSAGE_CRC_SIZE))
+            return false;
+        len -= MESSAGE_CRC_SIZE;
+    }
+
+    bit_reader_t r;
+    init_bit_reader(&r, buf + PACKED_PACKET_HEADER_SIZE, len - PACKED_PACKET_HEADER_SIZE);
+    uint32_t battery, last_tx_duration, temp, humidity;
+    if (!get_bits(&r, format->battery.bits, &battery)
+        || !get_bits(&r, format->last_tx_duration.bits, &last_tx_duration)
+        || !get_bits(&r, format->temp.bits, &temp)
+        || !get_bits(&r, format->humidity.bits, &humidity))
+        return false;
+
+    uint32_t message, time;
+    memcpy(&message, buf + 2, sizeof(uint32_t));
+    memcpy(&time, buf + 6, sizeof(uint32_t));
+
+    build_data_packet(data, buf[1], message, time, (uint16_t)unpack_fixed(battery, &format->battery),
+                      (uint16_t)unpack_fixed(last_tx_duration, &format->last_tx_duration),
+                      (int16_t)unpack_fixed(temp, &format->temp),
+                      (uint16_t)unpack_fixed(humidity, &format->humidity), buf[10]);
+    data->data = buf[11];
+
+    return true;
+}
@@ -0,0 +1,75 @@
+/**
+ * A bit-packed encoding for data packets. The sensor values in packet_t
+ * are 16-bit x100 integers, but none of them needs the full range; each
+ * is sent instead as (value - offset) / step in only as many bits as
+ * its range needs. A packed_format_t gives the offset, step and width
+ * of each field. Both ends must use the same format; the default one
+ * suits the soil moisture leaf nodes.
+ *
+ * Frame layout:
+ *  byte 0:     data_packed
+ *  byte 1:     node
+ *  bytes 2-5:  message
+ *  bytes 6-9:  time
+ *  byte 10:    status
+ *  byte 11:    data
+ *  then battery, last_tx_duration, temp and humidity, bit-packed (see
+ *  bit_pack.h).
+ *
+ * Values outside a field's range are clamped, and values inside it are
+ * rounded to the nearest step, so a packet comes back exactly only when
+ * its values are multiples of the steps.
+ */
+
+#ifndef h_packed_packet_h
+#define h_packed_packet_h
+
+#include <Arduino.h>
+
+#include "messages.h"
+#include "data_packet.h"
+
+/// Size of the byte-aligned part of a data_packed frame
+#define PACKED_PACKET_HEADER_SIZE 12
+
+/// The largest encoded data_packed frame in bytes; four 16-bit fields
+#define PACKED_PACKET_MAX_SIZE (PACKED_PACKET_HEADER_SIZE + 8)
+
+/**
+ * One packed field. The value sent is (v - offset) / step, rounded and
+ * clamped to 0 ... 2^bits - 1.
+ */
+struct packed_field_t {
+    int32_t offset;     // smallest value, same units as packet_t
+    uint16_t step;      // resolution, same units as packet_t
+    uint8_t bits;       // width, 1 - 16
+};
+
+struct packed_format_t {
+    packed_field_t battery;
+    packed_field_t last_tx_duration;
+    packed_field_t temp;
+    packed_field_t humidity;
+};
+
+/**
+ * Battery 2.50 - 5.05 V in 0.01 V steps (8 bits), last_tx_duration up to
+ * 16.4 s in 8 ms steps (11 bits), temp -40.0 - 164.7 C in 0.1 C steps (11
+ * bits) and humidity 0 - 102.3 % in 0.1 % steps (10 bits); 40 bits in
+ * all, so the frame is 17 bytes.
+ */
+extern const packed_format_t default_packed_format;
+
+bool packed_field_valid(const packed_field_t *field);
+bool packed_format_valid(const packed_format_t *format);
+
+uint32_t pack_fixed(int32_t value, const packed_field_t *field);
+int32_t unpack_fixed(uint32_t code, const packed_field_t *field);
+
+uint8_t packed_packet_size(const packed_format_t *format);
+uint8_t build_packed_packet(uint8_t *buf /* PACKED_PACKET_MAX_SIZE */, const packet_t *data,
+                            const packed_format_t *format = &default_packed_format);
+bool parse_packed_packet(const uint8_t *buf, uint8_t len, packet_t *data,
+                         const packed_format_t *format = &default_packed_format);
+
+#endif
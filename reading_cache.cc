@@ -0,0 +1,154 @@
+// Per-node columnar cache of recent readings.
+
+#include <Arduino.h>
+
+#include "reading_cache.h"
+
+/// A stored column value as a number; temp is signed
+static int32_t column_value(uint8_t column, uint16_t raw) {
+    return column == cache_temp ? (int32_t)(int16_t)raw : (int32_t)raw;
+}
+
+/// Find the min and max of a column in a full ring by looking at every reading
+static void rescan_column(node_readings_t *r, uint8_t column) {
+    column_stats_t *s = &r->stats[column];
+
+    s->min = s->max = column_value(column, r->values[column][0]);
+    for (uint8_t i = 1; i < READING_CACHE_DEPTH; ++i) {
+        int32_t v = column_value(column, r->values[column][i]);
+        if (v < s->min)
+            s->min = v;
+        if (v > s->max)
+            s->max = v;
+    }
+}
+
+/**
+ * @brief Empty the cache
+ * @param cache The cache
+ */
+void init_reading_cache(reading_cache_t *cache) {
+    memset(cache->slot, READING_CACHE_NONE, sizeof(cache->slot));
+    cache->used = 0;
+}
+
+/**
+ * @brief Add a reading to its node's ring
+ *
+ * If the ring is full the oldest reading is dropped.
+ *
+ * @param cache The cache
+ * @param data The reading
+ * @param moisture Soil moisture for the reading, e.g., the first
+ * sensor_soil_moisture value in a data_sensors frame (see sensor_packet.h)
+ * @return true if the reading was cached, false if the node has no ring
+ * and all READING_CACHE_NODES rings are in use.
+ */
+bool add_cached_reading(reading_cache_t *cache, const packet_t *data, uint16_t moisture /* 0 */) {
+    uint8_t slot = cache->slot[data->node];
+    if (slot == READING_CACHE_NONE) {
+        if (cache->used >= READING_CACHE_NODES)
+            return false;
+        slot = cache->slot[data->node] = cache->used++;
+        cache->nodes[slot].head = 0;
+        cache->nodes[slot].count = 0;
+        cache->nodes[slot].node = data->node;
+    }
+
+    node_readings_t *r = &cache->nodes[slot];
+    const uint16_t values[READING_CACHE_COLUMNS] = {data->battery, (uint16_t)data->temp, data->humidity, moisture};
+    bool full = r->count == READING_CACHE_DEPTH;
+
+    for (uint8_t c = 0; c < READING_CACHE_COLUMNS; ++c) {
+        column_stats_t *s = &r->stats[c];
+        int32_t v = column_value(c, values[c]);
+        // Until the ring is full, the slot at head has never been written
+        int32_t old = full ? column_value(c, r->values[c][r->head]) : 0;
+
+        r->values[c][r->head] = values[c];
+
+        if (r->count == 0) {
+            s->sum = s->min = s->max = v;
+            continue;
+        }
+
+        s->sum += v - old;
+        if (full && (old == s->min || old == s->max)) {
+            // The value that fell out was an extreme
+            rescan_column(r, c);
+        }
+        else {
+            if (v < s->min)
+                s->min = v;
+            if (v > s->max)
+                s->max = v;
+        }
+    }
+
+    r->time[r->head] = data->time;
+    r->head = (uint8_t)((r->head + 1) % READING_CACHE_DEPTH);
+    if (!full)
+        r->count++;
+
+    return true;
+}
+
+/**
+ * @brief How many readings are cached for a node
+ * @param cache The cache
+ * @param node The node number
+ * @return The number of readings, 0 to READING_CACHE_DEPTH
+ */
+uint8_t get_cached_count(const reading_cache_t *cache, uint8_t node) {
+    uint8_t slot = cache->slot[node];
+    return slot == READING_CACHE_NONE ? 0 : cache->nodes[slot].count;
+}
+
+/**
+ * @brief Get one cached reading
+ * @param cache The cache
+ * @param node The node number
+ * @param age 0 for the newest reading, 1 for the one before, ...
+ * @param reading V-R parameter for the reading
+ * @return true if the reading is in the cache, false otherwise.
+ */
+bool get_cached_reading(const reading_cache_t *cache, uint8_t node, uint8_t age, cached_reading_t *reading) {
+    uint8_t slot = cache->slot[node];
+    if (slot == READING_CACHE_NONE || age >= cache->nodes[slot].count)
+        return false;
+
+    const node_readings_t *r = &cache->nodes[slot];
+    uint8_t i = (uint8_t)((r->head + READING_CACHE_DEPTH - 1 - age) % READING_CACHE_DEPTH);
+
+    reading->time = r->time[i];
+    reading->battery = r->values[cache_battery][i];
+    reading->temp = (int16_t)r->values[cache_temp][i];
+    reading->humidity = r->values[cache_humidity][i];
+    reading->moisture = r->values[cache_moisture][i];
+
+    return true;
+}
+
+/**
+ * @brief Get the min, max and mean of one column for a node
+ * @param cache The cache
+ * @param node The node number
+ * @param column The column
+ * @param summary V-R parameter for the summary of the cached readings
+ * @return true if the node has cached readings, false otherwise.
+ */
+bool get_cached_summary(const reading_cache_t *cache, uint8_t node, CacheColumn column, reading_summary_t *summary) {
+    uint8_t slot = cache->slot[node];
+    if (slot == READING_CACHE_NONE || cache->nodes[slot].count == 0)
+        return false;
+
+    const node_readings_t *r = &cache->nodes[slot];
+    const column_stats_t *s = &r->stats[column];
+
+    summary->min = s->min;
+    summary->max = s->max;
+    summary->mean = s->sum / r->count;
+    summary->count = r->count;
+
+    return true;
+}
@@ -0,0 +1,92 @@
+/**
+ * The main node's cache of the most recent readings from each leaf.
+ *
+ * Each node gets a ring of READING_CACHE_DEPTH readings, stored as one
+ * array per column rather than as packet_t records, so there is no
+ * padding and a summary of a column touches only that column. The sum,
+ * min and max of each column over the readings in the ring are kept up
+ * to date as readings are added, so a summary is constant time; min and
+ * max are only recomputed when the reading that falls out of the ring
+ * held one of them.
+ *
+ * The first READING_CACHE_NODES nodes to send a reading get a ring;
+ * readings from other nodes are not cached. Set the sizes with compiler
+ * flags to trade history for RAM (every file must see the same values);
+ * each node takes about 12 * READING_CACHE_DEPTH + 52 bytes.
+ */
+
+#ifndef h_reading_cache_h
+#define h_reading_cache_h
+
+#include <Arduino.h>
+
+#include "data_packet.h"
+
+#ifndef READING_CACHE_NODES
+#define READING_CACHE_NODES 16
+#endif
+
+#ifndef READING_CACHE_DEPTH
+#define READING_CACHE_DEPTH 24
+#endif
+
+static_assert(READING_CACHE_DEPTH <= 255, "READING_CACHE_DEPTH must fit in a uint8_t");
+
+/// No ring for this node
+#define READING_CACHE_NONE 0xff
+
+/**
+ * The cached columns. temp is signed; the others are unsigned.
+ */
+enum CacheColumn {
+    cache_battery = 0,      // V * 100
+    cache_temp = 1,         // C * 100
+    cache_humidity = 2,     // % * 100
+    cache_moisture = 3,     // VWC % * 100
+};
+
+#define READING_CACHE_COLUMNS 4
+
+struct column_stats_t {
+    int32_t sum;
+    int32_t min;
+    int32_t max;
+};
+
+struct node_readings_t {
+    uint32_t time[READING_CACHE_DEPTH];
+    uint16_t values[READING_CACHE_COLUMNS][READING_CACHE_DEPTH];
+    column_stats_t stats[READING_CACHE_COLUMNS];
+    uint8_t head;           // where the next reading goes
+    uint8_t count;          // readings in the ring
+    uint8_t node;
+};
+
+struct reading_cache_t {
+    uint8_t slot[256];      // node number -> nodes[] index
+    node_readings_t nodes[READING_CACHE_NODES];
+    uint8_t used;
+};
+
+struct cached_reading_t {
+    uint32_t time;
+    uint16_t battery;
+    int16_t temp;
+    uint16_t humidity;
+    uint16_t moisture;
+};
+
+struct reading_summary_t {
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    uint8_t count;
+};
+
+void init_reading_cache(reading_cache_t *cache);
+bool add_cached_reading(reading_cache_t *cache, const packet_t *data, uint16_t moisture = 0);
+uint8_t get_cached_count(const reading_cache_t *cache, uint8_t node);
+bool get_cached_reading(const reading_cache_t *cache, uint8_t node, uint8_t age, cached_reading_t *reading);
+bool get_cached_summary(const reading_cache_t *cache, uint8_t node, CacheColumn column, reading_summary_t *summary);
+
+#endif
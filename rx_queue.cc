@@ -0,0 +1,115 @@
+// Lock-free queue between the radio and message processing.
+
+#include <Arduino.h>
+
+#include "rx_queue.h"
+
+// Keep the compiler from moving slot reads or writes across an index update
+#define RX_QUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @brief Empty the queue
+ * @param queue The queue
+ */
+void init_rx_queue(rx_queue_t *queue) {
+    memset(queue, 0, sizeof(rx_queue_t));
+}
+
+/** @name Producer */
+///@{
+/**
+ * @brief Get the next free slot to receive into
+ * Nothing is added to the queue until rx_queue_commit() is called.
+ * @param queue The queue
+ * @return A buffer of RH_RF95_MAX_MESSAGE_LEN bytes, or null if the
+ * queue is full.
+ */
+uint8_t *rx_queue_reserve(rx_queue_t *queue) {
+    uint8_t head = queue->head;
+    if ((uint8_t)(head - queue->tail) >= RX_QUEUE_SLOTS)
+        return 0;
+
+    return queue->slots[head & (RX_QUEUE_SLOTS - 1)].buf;
+}
+
+/**
+ * @brief Add the message received into the reserved slot to the queue
+ * @param queue The queue
+ * @param len The number of bytes received
+ */
+void rx_queue_commit(rx_queue_t *queue, uint8_t len) {
+    uint8_t head = queue->head;
+    queue->slots[head & (RX_QUEUE_SLOTS - 1)].len = len;
+    RX_QUEUE_BARRIER();
+    queue->head = head + 1;
+}
+
+/**
+ * @brief Copy a message into the queue
+ * @param queue The queue
+ * @param buf The message
+ * @param len The number of bytes in the message
+ * @return true if the message was queued, false if the queue is full
+ * or the message is too long; either way the message is counted as
+ * dropped.
+ */
+bool rx_queue_push(rx_queue_t *queue, const uint8_t *buf, uint8_t len) {
+    uint8_t *slot = rx_queue_reserve(queue);
+    if (!slot || len > RH_RF95_MAX_MESSAGE_LEN) {
+        rx_queue_drop(queue);
+        return false;
+    }
+
+    memcpy(slot, buf, len);
+    rx_queue_commit(queue, len);
+    return true;
+}
+
+/**
+ * @brief Count a received message that was thrown away
+ * Call this when a message had to be taken from the radio while
+ * rx_queue_reserve() had no slot for it.
+ * @param queue The queue
+ */
+void rx_queue_drop(rx_queue_t *queue) {
+    queue->dropped++;
+}
+///@}
+
+/** @name Consumer */
+///@{
+/**
+ * @brief Get the oldest message without removing it
+ * @param queue The queue
+ * @param len V-R parameter for the number of bytes in the message
+ * @return The message, valid until rx_queue_pop(), or null if the
+ * queue is empty.
+ */
+const uint8_t *rx_queue_front(const rx_queue_t *queue, uint8_t *len) {
+    uint8_t tail = queue->tail;
+    if (queue->head == tail)
+        return 0;
+
+    RX_QUEUE_BARRIER();
+    const rx_slot_t *slot = &queue->slots[tail & (RX_QUEUE_SLOTS - 1)];
+    *len = slot->len;
+    return slot->buf;
+}
+
+/**
+ * @brief Remove the oldest message, freeing its slot
+ * @param queue The queue; must not be empty
+ */
+void rx_queue_pop(rx_queue_t *queue) {
+    RX_QUEUE_BARRIER();
+    queue->tail = queue->tail + 1;
+}
+
+/**
+ * @brief The number of messages waiting
+ * @param queue The queue
+ */
+uint8_t rx_queue_count(const rx_queue_t *queue) {
+    return (uint8_t)(queue->head - queue->tail);
+}
+///@}
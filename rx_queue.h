@@ -0,0 +1,71 @@
+/**
+ * A single-producer, single-consumer queue of received radio messages.
+ *
+ * The radio side (an interrupt handler or the top of loop()) copies each
+ * message into a slot and the main loop takes them out and dispatches
+ * them when it has time, so a slow SD card write does not make the node
+ * miss the next packet. The messages can go straight from the radio into
+ * a slot:
+ *
+ * @code
+ * uint8_t *slot = rx_queue_reserve(&queue);
+ * uint8_t len = RH_RF95_MAX_MESSAGE_LEN;
+ * if (slot && rf95.recv(slot, &len))
+ *     rx_queue_commit(&queue, len);
+ * else if (!slot && rf95.available()) {
+ *     rf95.recv(scratch, &len);   // make room in the radio for the next one
+ *     rx_queue_drop(&queue);
+ * }
+ * ...
+ * while ((msg = rx_queue_front(&queue, &len))) {
+ *     dispatch_message(&handlers, msg, len, &state);
+ *     rx_queue_pop(&queue);
+ * }
+ * @endcode
+ *
+ * While the queue is full a message can wait in the radio, so a full
+ * queue alone loses nothing. A message is only counted as dropped when
+ * it is actually thrown away: by rx_queue_push() or by the producer
+ * calling rx_queue_drop().
+ *
+ * No locks are needed: only the producer writes head and only the
+ * consumer writes tail. This relies on there being one core, which is
+ * true of every board this library runs on.
+ */
+
+#ifndef h_rx_queue_h
+#define h_rx_queue_h
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+
+/// The number of slots; must be a power of two no larger than 128
+#define RX_QUEUE_SLOTS 8
+
+static_assert((RX_QUEUE_SLOTS & (RX_QUEUE_SLOTS - 1)) == 0 && RX_QUEUE_SLOTS <= 128,
+              "RX_QUEUE_SLOTS must be a power of two no larger than 128");
+
+struct rx_slot_t {
+    uint8_t len;
+    uint8_t buf[RH_RF95_MAX_MESSAGE_LEN];
+};
+
+struct rx_queue_t {
+    rx_slot_t slots[RX_QUEUE_SLOTS];
+    volatile uint8_t head;  // next slot to fill; written by the producer
+    volatile uint8_t tail;  // next slot to drain; written by the consumer
+    uint16_t dropped;       // received messages thrown away, see rx_queue_drop()
+};
+
+void init_rx_queue(rx_queue_t *queue);
+
+uint8_t *rx_queue_reserve(rx_queue_t *queue);
+void rx_queue_commit(rx_queue_t *queue, uint8_t len);
+bool rx_queue_push(rx_queue_t *queue, const uint8_t *buf, uint8_t len);
+void rx_queue_drop(rx_queue_t *queue);
+
+const uint8_t *rx_queue_front(const rx_queue_t *queue, uint8_t *len);
+void rx_queue_pop(rx_queue_t *queue);
+uint8_t rx_queue_count(const rx_queue_t *queue);
+
+#endif
@@ -0,0 +1,95 @@
+// Sector-aligned buffered writes.
+
+#include <Arduino.h>
+
+#include "sector_writer.h"
+
+/**
+ * @brief Set up a writer
+ * @param w The writer
+ * @param sink Called with each sector (or partial sector on a flush)
+ * @param context Passed to sink
+ * @param file_size Optional, the current size of the file when appending
+ * to an existing one, so that writes stay sector aligned. Default: 0
+ */
+void init_sector_writer(sector_writer_t *w, sector_sink_t sink, void *context, uint32_t file_size /* 0 */) {
+    w->used = 0;
+    w->offset = file_size % SECTOR_SIZE;
+    w->sink = sink;
+    w->context = context;
+}
+
+/**
+ * @brief Pass the buffered bytes to the sink
+ * @return true if the sink took them, false if they are still buffered
+ */
+static bool emit(sector_writer_t *w) {
+    if (w->used == 0)
+        return true;
+
+    if (!w->sink(w->buf, w->used, w->context))
+        return false;
+
+    w->offset = (w->offset + w->used) % SECTOR_SIZE;
+    w->used = 0;
+    return true;
+}
+
+/**
+ * @brief Write bytes
+ *
+ * Bytes are buffered until they complete a sector. When the buffer is
+ * empty and the file is sector aligned, whole sectors are passed to
+ * the sink directly from data without being copied.
+ *
+ * A byte is consumed once it has been passed to the sink or copied into
+ * the buffer. If the sink fails, writing stops and the bytes consumed so
+ * far stay consumed; the caller retries from data + the return value.
+ *
+ * @param w The writer
+ * @param data The bytes to write
+ * @param len The number of bytes
+ * @return The number of bytes consumed; less than len only if the sink
+ * failed.
+ */
+size_t sector_writer_write(sector_writer_t *w, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    size_t consumed = 0;
+
+    while (consumed < len) {
+        size_t left = len - consumed;
+        if (w->used == 0 && w->offset == 0 && left >= SECTOR_SIZE) {
+            size_t whole = left - left % SECTOR_SIZE;
+            if (!w->sink(p + consumed, whole, w->context))
+                break;
+            consumed += whole;
+            continue;
+        }
+
+        size_t room = SECTOR_SIZE - w->offset - w->used;
+        if (room == 0) {
+            if (!emit(w))
+                break;
+            continue;
+        }
+
+        size_t n = (left < room) ? left : room;
+        memcpy(w->buf + w->used, p + consumed, n);
+        w->used += n;
+        consumed += n;
+
+        if (w->offset + w->used == SECTOR_SIZE && !emit(w))
+            break;
+    }
+
+    return consumed;
+}
+
+/**
+ * @brief Write out whatever is buffered, even part of a sector
+ * @param w The writer
+ * @return true if the buffer is now empty, false if the sink failed.
+ */
+bool sector_writer_flush(sector_writer_t *w) {
+    return emit(w);
+}
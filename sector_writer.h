@@ -0,0 +1,43 @@
+/**
+ * Buffer writes to an SD card file and pass them on in whole, aligned
+ * 512 byte sectors. Writing less than a sector makes the SD library
+ * read, modify and write back the whole sector; collecting records here
+ * first avoids that and the long stalls it causes.
+ *
+ * The writer does not depend on a particular SD library. The caller
+ * provides a sink, typically a wrapper around File::write():
+ *
+ * @code
+ * bool write_to_file(const uint8_t *buf, size_t len, void *context) {
+ *     return ((File *)context)->write(buf, len) == len;
+ * }
+ * @endcode
+ *
+ * Call sector_writer_flush() before the node sleeps or when the battery
+ * is low so buffered records are not lost. The writer tracks where the
+ * file is within its current sector, so the next full flush after a
+ * partial one realigns the file.
+ */
+
+#ifndef h_sector_writer_h
+#define h_sector_writer_h
+
+#include <Arduino.h>
+
+#define SECTOR_SIZE 512
+
+typedef bool (*sector_sink_t)(const uint8_t *buf, size_t len, void *context);
+
+struct sector_writer_t {
+    uint8_t buf[SECTOR_SIZE];
+    uint16_t used;      // bytes waiting in buf
+    uint16_t offset;    // position of buf[0] within its sector of the file
+    sector_sink_t sink;
+    void *context;
+};
+
+void init_sector_writer(sector_writer_t *w, sector_sink_t sink, void *context, uint32_t file_size = 0);
+size_t sector_writer_write(sector_writer_t *w, const void *data, size_t len);
+bool sector_writer_flush(sector_writer_t *w);
+
+#endif
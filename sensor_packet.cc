@@ -0,0 +1,207 @@
+// functions to build, parse and print data packets with extra sensors.
+
+#include <Arduino.h>
+
+#include "sensor_packet.h"
+
+/**
+ * @brief Start a data_sensors frame
+ * @param buf Destination, at least SENSOR_PACKET_MAX_SIZE bytes
+ * @param data The packet_t part of the frame
+ * @return The length of the frame so far; pass it to add_sensor_reading()
+ */
+uint8_t build_sensor_packet(uint8_t *buf, const packet_t *data) {
+    memcpy(buf, data, DATA_PACKET_SIZE);
+    buf[0] = data_sensors;
+
+    return DATA_PACKET_SIZE;
+}
+
+/**
+ * @brief Add a reading to a data_sensors frame
+ * @param buf The frame
+ * @param len The length of the frame so far
+ * @param tag The sensor type, a SensorTag
+ * @param value The value, in wire format
+ * @param size The number of bytes in value
+ * @return The new length of the frame. If the reading does not fit, the
+ * frame is unchanged and len is returned, so calls can be chained as
+ * len = add_sensor_reading(buf, len, ...).
+ */
+uint8_t add_sensor_reading(uint8_t *buf, uint8_t len, uint8_t tag, const void *value, uint8_t size) {
+    if ((size_t)len + SENSOR_READING_HEADER_SIZE + size > SENSOR_PACKET_MAX_SIZE)
+        return len;
+
+    buf[len++] = tag;
+    buf[len++] = size;
+    memcpy(buf + len, value, size);
+
+    return len + size;
+}
+
+/**
+ * @brief Add a reading from a probe at some depth
+ * @param buf The frame
+ * @param len The length of the frame so far
+ * @param tag sensor_soil_moisture, sensor_soil_temp or sensor_soil_conductivity
+ * @param depth The probe's depth in cm
+ * @param value The reading; for sensor_soil_temp, an int16_t cast to uint16_t
+ * @return The new length of the frame; len if the reading does not fit.
+ */
+uint8_t add_sensor_probe(uint8_t *buf, uint8_t len, SensorTag tag, uint8_t depth, uint16_t value) {
+    uint8_t v[SENSOR_PROBE_VALUE_SIZE];
+    v[0] = depth;
+    memcpy(v + 1, &value, sizeof(uint16_t));
+
+    return add_sensor_reading(buf, len, tag, v, sizeof(v));
+}
+
+/**
+ * @brief Check a data_sensors frame and extract its packet_t part
+ *
+ * Every reading is checked, so next_sensor_reading() cannot fail on a
+ * frame that passes.
+ *
+ * @param buf The frame
+ * @param len The number of bytes in the frame
+ * @param data If not null, V-R parameter for the packet; its type is
+ * set to data_packet so it can be used like any other packet
+ * @param end If not null, V-R parameter for the end of the readings,
+ * i.e., len without the CRC trailer
+ * @return true if this is a well-formed data_sensors frame, false otherwise.
+ */
+bool parse_sensor_packet(const uint8_t *buf, uint8_t len, packet_t *data, uint8_t *end) {
+    if (len < DATA_PACKET_SIZE || get_message_type(buf) != data_sensors)
+        return false;
+
+    if (message_has_crc(buf)) {
+        if (len < DATA_PACKET_SIZE + MESSAGE_CRC_SIZE || !check_message_crc(buf, len - MESSAGE_CRC_SIZE))
+            return false;
+        len -= MESSAGE_CRC_SIZE;
+    }
+
+    uint8_t offset = DATA_PACKET_SIZE;
+    while (offset < len) {
+        if (len - offset < SENSOR_READING_HEADER_SIZE || len - offset - SENSOR_READING_HEADER_SIZE < buf[offset + 1])
+            return false;
+        offset += SENSOR_READING_HEADER_SIZE + buf[offset + 1];
+    }
+
+    if (data) {
+        memcpy(data, buf, DATA_PACKET_SIZE);
+        data->type = data_packet;
+    }
+    if (end)
+        *end = len;
+
+    return true;
+}
+
+/**
+ * @brief Step through the readings in a data_sensors frame
+ *
+ * @code
+ * uint8_t end, offset = DATA_PACKET_SIZE;
+ * sensor_reading_t r;
+ * if (parse_sensor_packet(buf, len, &packet, &end))
+ *     while (next_sensor_reading(buf, end, &offset, &r))
+ *         ...
+ * @endcode
+ *
+ * @param buf The frame
+ * @param end The end of the readings, from parse_sensor_packet()
+ * @param offset The offset of the next reading; start at DATA_PACKET_SIZE
+ * @param reading V-R parameter for the reading
+ * @return true if there was another reading, false otherwise.
+ */
+bool next_sensor_reading(const uint8_t *buf, uint8_t end, uint8_t *offset, sensor_reading_t *reading) {
+    uint8_t n = *offset;
+    if (n + SENSOR_READING_HEADER_SIZE > end || n + SENSOR_READING_HEADER_SIZE + buf[n + 1] > end)
+        return false;
+
+    reading->tag = buf[n];
+    reading->length = buf[n + 1];
+    reading->value = buf + n + SENSOR_READING_HEADER_SIZE;
+    *offset = n + SENSOR_READING_HEADER_SIZE + reading->length;
+
+    return true;
+}
+
+/**
+ * @brief Get the depth and value of a probe reading
+ * @param reading The reading
+ * @param depth If not null, V-R parameter for the depth in cm
+ * @param value If not null, V-R parameter for the value
+ * @return true if the reading is a probe reading, false otherwise.
+ */
+bool get_sensor_probe(const sensor_reading_t *reading, uint8_t *depth, uint16_t *value) {
+    switch (reading->tag) {
+        case sensor_soil_moisture:
+        case sensor_soil_temp:
+        case sensor_soil_conductivity:
+            break;
+        default:
+            return false;
+    }
+    if (reading->length != SENSOR_PROBE_VALUE_SIZE)
+        return false;
+
+    if (depth)
+        *depth = reading->value[0];
+    if (value)
+        memcpy(value, reading->value + 1, sizeof(uint16_t));
+
+    return true;
+}
+
+/**
+ * @brief Get the name for a sensor tag
+ */
+char *get_sensor_tag_string(uint8_t tag) {
+    switch (tag) {
+        case sensor_soil_moisture:
+            return (char*)"soil moisture";
+        case sensor_soil_temp:
+            return (char*)"soil temp";
+        case sensor_soil_conductivity:
+            return (char*)"soil conductivity";
+
+        default:
+            return (char*)"unknown";
+    }
+}
+
+/**
+ * @brief Write a string representation for one reading
+ *
+ * Probe readings are printed as tag, depth and value; others as the tag
+ * and the value's length.
+ *
+ * @param reading The reading
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t sensor_reading_to_string(const sensor_reading_t *reading, char *buf, size_t len, bool pretty /* false */) {
+    uint8_t depth = 0;
+    uint16_t value = 0;
+    int n;
+
+    if (get_sensor_probe(reading, &depth, &value)) {
+        long v = reading->tag == sensor_soil_temp ? (long)(int16_t)value : (long)value;
+        if (pretty)
+            n = snprintf(buf, len, "%s: depth: %u cm, value: %ld", get_sensor_tag_string(reading->tag), depth, v);
+        else
+            n = snprintf(buf, len, "%u, %u, %ld", reading->tag, depth, v);
+    }
+    else {
+        if (pretty)
+            n = snprintf(buf, len, "%s (%u): %u bytes", get_sensor_tag_string(reading->tag), reading->tag,
+                         reading->length);
+        else
+            n = snprintf(buf, len, "%u, %u", reading->tag, reading->length);
+    }
+
+    return written_length(n, len);
+}
@@ -0,0 +1,68 @@
+/**
+ * A data packet followed by readings from any number of extra sensors,
+ * e.g., soil moisture probes at several depths.
+ *
+ * Frame layout:
+ *  bytes 0 - 19:   a packet_t, with data_sensors as its type
+ *  then zero or more readings, each:
+ *   byte 0:    tag, a SensorTag
+ *   byte 1:    length of the value in bytes
+ *   then the value
+ *
+ * A leaf sends only the sensors it has. A receiver that does not know a
+ * tag can skip it using the length, so new sensor types can be added
+ * without changing nodes that do not use them.
+ */
+
+#ifndef h_sensor_packet_h
+#define h_sensor_packet_h
+
+#include <Arduino.h>
+#include <RH_RF95.h>
+
+#include "messages.h"
+#include "data_packet.h"
+
+/// The largest data_sensors frame in bytes, leaving room for a CRC trailer
+#define SENSOR_PACKET_MAX_SIZE (RH_RF95_MAX_MESSAGE_LEN - MESSAGE_CRC_SIZE)
+
+/// Size of a reading's tag and length in bytes
+#define SENSOR_READING_HEADER_SIZE 2
+
+/**
+ * Registered sensor types. Values are little-endian, like the rest of
+ * the wire format. Tags from sensor_local up are free for a site's own
+ * sensors.
+ */
+enum SensorTag : uint8_t {
+    sensor_soil_moisture = 1,       // depth cm (uint8_t), VWC % * 100 (uint16_t)
+    sensor_soil_temp = 2,           // depth cm (uint8_t), C * 100 (int16_t)
+    sensor_soil_conductivity = 3,   // depth cm (uint8_t), uS/cm (uint16_t)
+
+    sensor_local = 0x80,
+};
+
+/// Size of the value of each registered depth/value sensor
+#define SENSOR_PROBE_VALUE_SIZE 3
+
+/**
+ * One reading in a data_sensors frame; value points into the frame.
+ */
+struct sensor_reading_t {
+    uint8_t tag;
+    uint8_t length;
+    const uint8_t *value;
+};
+
+uint8_t build_sensor_packet(uint8_t *buf /* SENSOR_PACKET_MAX_SIZE */, const packet_t *data);
+uint8_t add_sensor_reading(uint8_t *buf, uint8_t len, uint8_t tag, const void *value, uint8_t size);
+uint8_t add_sensor_probe(uint8_t *buf, uint8_t len, SensorTag tag, uint8_t depth, uint16_t value);
+
+bool parse_sensor_packet(const uint8_t *buf, uint8_t len, packet_t *data, uint8_t *end);
+bool next_sensor_reading(const uint8_t *buf, uint8_t end, uint8_t *offset, sensor_reading_t *reading);
+bool get_sensor_probe(const sensor_reading_t *reading, uint8_t *depth, uint16_t *value);
+
+char *get_sensor_tag_string(uint8_t tag);
+size_t sensor_reading_to_string(const sensor_reading_t *reading, char *buf, size_t len, bool pretty = false);
+
+#endif
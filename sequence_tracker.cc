@@ -0,0 +1,108 @@
+// Duplicate and loss detection for data packets.
+
+#include <Arduino.h>
+
+#include "sequence_tracker.h"
+
+#define COUNTER_MAX 0xffff
+
+/// Add to a counter, stopping at its largest value
+static void count(uint16_t *counter, uint32_t n) {
+    *counter = (*counter + n > COUNTER_MAX) ? COUNTER_MAX : (uint16_t)(*counter + n);
+}
+
+/**
+ * @brief Clear the state for every node
+ * @param tracker The tracker
+ */
+void init_sequence_tracker(sequence_tracker_t *tracker) {
+    memset(tracker, 0, sizeof(sequence_tracker_t));
+}
+
+/**
+ * @brief Start tracking a node again from this packet
+ */
+static SequenceResult restart(node_sequence_t *s, uint32_t message, uint32_t time) {
+    s->last = message;
+    s->time = time;
+    s->window = 1;
+    s->received++;
+    return sequence_restart;
+}
+
+/**
+ * @brief Record a packet and classify it
+ *
+ * A jump forward counts the message numbers skipped as lost; a late
+ * packet that fills one of those gaps takes it off the lost count,
+ * unless the count has saturated and is no longer exact.
+ *
+ * Leaf nodes number their packets from 0 after a reset. A packet that
+ * is not ahead of the newest but was read after it (its time is later)
+ * can only come from a leaf that was reset, so it restarts tracking
+ * for the node. So does message 0 when the window holds no message 0,
+ * in case the leaf has not set its clock yet, and a packet more than
+ * SEQUENCE_WINDOW behind the newest, in case the first packets after
+ * the reset were lost.
+ *
+ * @param tracker The tracker
+ * @param node The node number from the packet
+ * @param message The message number from the packet
+ * @param time The time from the packet
+ * @return How the packet relates to those already seen.
+ */
+SequenceResult track_sequence(sequence_tracker_t *tracker, uint8_t node, uint32_t message, uint32_t time) {
+    node_sequence_t *s = &tracker->nodes[node];
+
+    if (s->received == 0) {
+        s->last = message;
+        s->time = time;
+        s->window = 1;
+        s->received = 1;
+        return sequence_new;
+    }
+
+    uint32_t ahead = message - s->last;
+    if (ahead != 0 && ahead < 0x80000000u) {
+        s->window = (ahead < SEQUENCE_WINDOW) ? (s->window << ahead) | 1 : 1;
+        s->last = message;
+        s->time = time;
+        s->received++;
+        count(&s->lost, ahead - 1);
+        return sequence_new;
+    }
+
+    // A retransmission has the time of the original, which is no later
+    // than the newest packet's
+    if (time > s->time)
+        return restart(s, message, time);
+
+    bool seen_zero = s->last < SEQUENCE_WINDOW && (s->window & ((uint32_t)1 << s->last));
+    if (message == 0 && s->last != 0 && !seen_zero)
+        return restart(s, message, time);
+
+    uint32_t behind = s->last - message;
+    if (behind >= SEQUENCE_WINDOW)
+        return restart(s, message, time);
+
+    uint32_t bit = (uint32_t)1 << behind;
+    if (s->window & bit) {
+        count(&s->duplicates, 1);
+        return sequence_duplicate;
+    }
+    s->window |= bit;
+    s->received++;
+    if (s->lost && s->lost != COUNTER_MAX)
+        s->lost--;
+    return sequence_late;
+}
+
+/**
+ * @brief Get the counters for one node
+ * @param tracker The tracker
+ * @param node The node number
+ * @return The node's state; received is 0 if nothing has been heard from it.
+ */
+const node_sequence_t *get_node_sequence(const sequence_tracker_t *tracker, uint8_t node) {
+    return &tracker->nodes[node];
+}
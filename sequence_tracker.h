@@ -0,0 +1,52 @@
+/**
+ * Per-node tracking of data packet message numbers on the main node.
+ *
+ * packet_t::message is a sequence number per leaf node. For each node
+ * the tracker keeps the highest message number seen and a bitmap of the
+ * SEQUENCE_WINDOW message numbers before it, which is enough to spot a
+ * retransmission the main node has already logged and to count the
+ * packets that never arrived. Each update is constant time.
+ *
+ * The tracker is also given each packet's time. A retransmission
+ * carries the time of the original reading, but a leaf that was reset
+ * sends new readings with later times. That distinguishes a restart
+ * from a retransmission even when the leaf resets again within
+ * SEQUENCE_WINDOW messages of its last reset.
+ */
+
+#ifndef h_sequence_tracker_h
+#define h_sequence_tracker_h
+
+#include <Arduino.h>
+
+/// The number of message numbers behind the newest that are tracked
+#define SEQUENCE_WINDOW 32
+
+/** 
+ * The result of tracking one packet.
+ */
+enum SequenceResult {
+    sequence_new = 0,       // the newest packet from this node
+    sequence_late = 1,      // an older packet that had been counted as lost
+    sequence_duplicate = 2, // already received; drop it
+    sequence_restart = 3,   // not ahead of the newest but read later, or far behind; the leaf was reset
+};
+
+struct node_sequence_t {
+    uint32_t last;          // highest message number seen
+    uint32_t time;          // packet_t::time of message 'last'
+    uint32_t window;        // bit i set if message (last - i) was received
+    uint32_t received;      // 0 == no packets from this node yet
+    uint16_t lost;          // stops at 0xffff
+    uint16_t duplicates;
+};
+
+struct sequence_tracker_t {
+    node_sequence_t nodes[256];
+};
+
+void init_sequence_tracker(sequence_tracker_t *tracker);
+SequenceResult track_sequence(sequence_tracker_t *tracker, uint8_t node, uint32_t message, uint32_t time);
+const node_sequence_t *get_node_sequence(const sequence_tracker_t *tracker, uint8_t node);
+
+#endif
@@ -0,0 +1,70 @@
+// Time-slotted transmit schedule.
+
+#include <Arduino.h>
+
+#include "slot_schedule.h"
+
+/**
+ * @brief Assign a node its transmit slot
+ *
+ * Node numbers are handed out in order (see join_table.h), so node n
+ * gets slot n - 1 and nodes share a slot only when there are more nodes
+ * than slots.
+ *
+ * @param slot The slot, set to 'no schedule' on error
+ * @param node The node number, 1 - 254
+ * @param slot_length Seconds per slot
+ * @param frame_length Seconds per frame
+ * @return False if the frame is shorter than one slot, true otherwise
+ */
+bool make_tx_slot(tx_slot_t *slot, uint8_t node, uint8_t slot_length, uint16_t frame_length) {
+    slot->slot = 0;
+    slot->slot_length = 0;
+    slot->frame_length = 0;
+
+    if (slot_length == 0 || frame_length < slot_length)
+        return false;
+
+    slot->slot_length = slot_length;
+    slot->frame_length = frame_length;
+    slot->slot = (uint8_t)((uint8_t)(node - 1) % get_slot_count(slot));
+
+    return true;
+}
+
+/**
+ * @brief How many slots the schedule has
+ * @param slot The slot
+ * @return The number of slots per frame, at most 256; 0 if there is no schedule
+ */
+uint16_t get_slot_count(const tx_slot_t *slot) {
+    if (slot->slot_length == 0 || slot->frame_length < slot->slot_length)
+        return 0;
+
+    uint16_t count = slot->frame_length / slot->slot_length;
+    return count > 256 ? 256 : count;
+}
+
+/**
+ * @brief When a leaf may next transmit
+ *
+ * The leaf calls this with the time it would like to send (e.g., its last
+ * reading plus the report interval) and sleeps until the returned time.
+ *
+ * @param slot The leaf's slot from its join or time response
+ * @param earliest The earliest time to send, Unix time
+ * @return The start of the first of the leaf's slots at or after
+ * earliest; earliest itself if there is no schedule or the slot does not
+ * fit in the frame.
+ */
+uint32_t next_slot_time(const tx_slot_t *slot, uint32_t earliest) {
+    uint16_t count = get_slot_count(slot);
+    if (count == 0 || slot->slot >= count)
+        return earliest;
+
+    uint32_t start = earliest - earliest % slot->frame_length + (uint32_t)slot->slot * slot->slot_length;
+    if (start < earliest)
+        start += slot->frame_length;
+
+    return start;
+}
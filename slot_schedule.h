@@ -0,0 +1,24 @@
+/**
+ * Time-slotted (TDMA) transmit schedule.
+ *
+ * Time is divided into frames that start whenever the Unix time is a
+ * multiple of the frame length, and each frame into equal slots. The main
+ * node gives each leaf a slot with make_tx_slot() and sends it in the
+ * join response and every time response; the leaf then transmits only at
+ * the start of its slot, found with next_slot_time(), so leaves that
+ * share a gateway no longer collide. The slot length should cover a
+ * packet's airtime, its ACK and the worst clock error between syncs.
+ */
+
+#ifndef h_slot_schedule_h
+#define h_slot_schedule_h
+
+#include <Arduino.h>
+
+#include "messages.h"
+
+bool make_tx_slot(tx_slot_t *slot, uint8_t node, uint8_t slot_length, uint16_t frame_length);
+uint16_t get_slot_count(const tx_slot_t *slot);
+uint32_t next_slot_time(const tx_slot_t *slot, uint32_t earliest);
+
+#endif
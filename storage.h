@@ -0,0 +1,18 @@
+/**
+ * Non-volatile storage used to persist state across resets. The library
+ * does not depend on a particular device; the sketch fills in a
+ * storage_t with functions for its EEPROM, flash or FRAM.
+ */
+
+#ifndef h_storage_h
+#define h_storage_h
+
+#include <Arduino.h>
+
+struct storage_t {
+    bool (*read)(uint32_t address, void *buf, size_t len, void *context);
+    bool (*write)(uint32_t address, const void *buf, size_t len, void *context);
+    void *context;
+};
+
+#endif
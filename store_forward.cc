@@ -0,0 +1,136 @@
+// Store-and-forward queue for leaf nodes.
+
+#include <Arduino.h>
+
+#include "store_forward.h"
+
+/// Address of a slot in the spill area
+static uint32_t spill_slot(const sf_queue_t *queue, uint16_t index) {
+    return queue->spill_address
+           + (uint32_t)((queue->spill_head + index) % queue->spill_capacity) * DATA_PACKET_SIZE;
+}
+
+/**
+ * @brief Set up an empty queue
+ * @param queue The queue
+ * @param storage Optional, the device for the spill area. Default: none
+ * @param spill_address Optional, where the spill area starts
+ * @param spill_capacity Optional, how many packets the spill area holds
+ */
+void init_sf_queue(sf_queue_t *queue, const storage_t *storage /* 0 */, uint32_t spill_address /* 0 */,
+                   uint16_t spill_capacity /* 0 */) {
+    memset(queue, 0, sizeof(sf_queue_t));
+    queue->storage = spill_capacity ? storage : 0;
+    queue->spill_address = spill_address;
+    queue->spill_capacity = spill_capacity;
+}
+
+/**
+ * @brief Add a packet that could not be sent
+ * @param queue The queue
+ * @param data The packet
+ */
+void sf_queue_push(sf_queue_t *queue, const packet_t *data) {
+    if (queue->ram_count == SF_RAM_RECORDS) {
+        const packet_t *oldest = &queue->ram[queue->ram_head];
+        bool spilled = false;
+
+        if (queue->storage) {
+            if (queue->spill_count == queue->spill_capacity) {
+                queue->spill_head = (queue->spill_head + 1) % queue->spill_capacity;
+                queue->spill_count--;
+                queue->dropped++;
+            }
+            spilled = queue->storage->write(spill_slot(queue, queue->spill_count), oldest, DATA_PACKET_SIZE,
+                                            queue->storage->context);
+            if (spilled)
+                queue->spill_count++;
+        }
+
+        if (!spilled)
+            queue->dropped++;
+
+        queue->ram_head = (queue->ram_head + 1) % SF_RAM_RECORDS;
+        queue->ram_count--;
+    }
+
+    queue->ram[(queue->ram_head + queue->ram_count) % SF_RAM_RECORDS] = *data;
+    queue->ram_count++;
+}
+
+/**
+ * @brief The number of packets waiting
+ * @param queue The queue
+ */
+uint16_t sf_queue_count(const sf_queue_t *queue) {
+    return queue->spill_count + queue->ram_count;
+}
+
+/**
+ * @brief Get a waiting packet without removing it
+ * @param queue The queue
+ * @param index 0 for the oldest packet
+ * @param data V-R parameter for the packet
+ * @return true if the packet was read, false otherwise.
+ */
+bool sf_queue_peek(const sf_queue_t *queue, uint16_t index, packet_t *data) {
+    if (index < queue->spill_count)
+        return queue->storage->read(spill_slot(queue, index), data, DATA_PACKET_SIZE, queue->storage->context);
+
+    index -= queue->spill_count;
+    if (index >= queue->ram_count)
+        return false;
+
+    *data = queue->ram[(queue->ram_head + index) % SF_RAM_RECORDS];
+    return true;
+}
+
+/**
+ * @brief Pack the oldest waiting packets into a batch
+ *
+ * The batch ends early at a break in the message numbers or at a
+ * spilled packet that cannot be read. The packets stay in the queue
+ * until sf_queue_release() is called. An unreadable packet at the front
+ * of the queue is removed and counted in queue->unreadable; otherwise
+ * every later call would stop at it and the queue would never drain.
+ *
+ * @param queue The queue
+ * @param batch The batch to fill
+ * @return The number of packets in the batch; 0 if the queue is empty.
+ */
+uint8_t sf_queue_fill_batch(sf_queue_t *queue, data_batch_t *batch) {
+    packet_t data;
+    while (!sf_queue_peek(queue, 0, &data)) {
+        if (queue->spill_count == 0)
+            return 0;
+        sf_queue_release(queue, 1);
+        queue->unreadable++;
+    }
+
+    build_data_batch(batch, data.node);
+    uint16_t i = 0;
+    do {
+        if (!add_data_batch_reading(batch, &data))
+            break;
+    } while (++i < sf_queue_count(queue) && sf_queue_peek(queue, i, &data));
+
+    return batch->count;
+}
+
+/**
+ * @brief Remove the oldest packets once they have been delivered
+ * @param queue The queue
+ * @param count The number of packets to remove
+ */
+void sf_queue_release(sf_queue_t *queue, uint16_t count) {
+    uint16_t n = (count < queue->spill_count) ? count : queue->spill_count;
+    if (n) {
+        queue->spill_head = (queue->spill_head + n) % queue->spill_capacity;
+        queue->spill_count -= n;
+        count -= n;
+    }
+
+    n = (count < queue->ram_count) ? count : queue->ram_count;
+    queue->ram_head = (queue->ram_head + n) % SF_RAM_RECORDS;
+    queue->ram_count -= n;
+}
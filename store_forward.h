@@ -0,0 +1,54 @@
+/**
+ * The leaf node's store-and-forward queue of data packets.
+ *
+ * Packets that could not be delivered are held in a RAM ring of
+ * SF_RAM_RECORDS packets. When that fills, the oldest packets are moved
+ * to a spill area in external flash or FRAM (optional, see storage.h),
+ * so the spill area always holds the oldest packets and the RAM ring the
+ * newest. When both are full the oldest packet is dropped.
+ *
+ * Once the main node can be reached again, sf_queue_fill_batch() packs
+ * the oldest packets into a data_batch_t; after the batch is
+ * acknowledged, sf_queue_release() removes them. A spilled packet that
+ * cannot be read back is skipped and counted in 'unreadable', so one bad
+ * sector does not stop the queue from draining.
+ *
+ * The queue indices are kept in RAM, so the queue does not survive
+ * a reset.
+ */
+
+#ifndef h_store_forward_h
+#define h_store_forward_h
+
+#include <Arduino.h>
+
+#include "data_packet.h"
+#include "data_batch.h"
+#include "storage.h"
+
+#define SF_RAM_RECORDS 16
+
+struct sf_queue_t {
+    packet_t ram[SF_RAM_RECORDS];
+    uint8_t ram_head;           // oldest packet in ram
+    uint8_t ram_count;
+
+    const storage_t *storage;   // null == no spill area
+    uint32_t spill_address;
+    uint16_t spill_capacity;    // packets
+    uint16_t spill_head;        // oldest packet in the spill area
+    uint16_t spill_count;
+
+    uint32_t dropped;           // oldest packets pushed out of a full queue
+    uint32_t unreadable;        // spilled packets skipped because they could not be read
+};
+
+void init_sf_queue(sf_queue_t *queue, const storage_t *storage = 0, uint32_t spill_address = 0,
+                   uint16_t spill_capacity = 0);
+void sf_queue_push(sf_queue_t *queue, const packet_t *data);
+uint16_t sf_queue_count(const sf_queue_t *queue);
+bool sf_queue_peek(const sf_queue_t *queue, uint16_t index, packet_t *data);
+uint8_t sf_queue_fill_batch(sf_queue_t *queue, data_batch_t *batch);
+void sf_queue_release(sf_queue_t *queue, uint16_t count);
+
+#endif
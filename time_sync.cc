@@ -0,0 +1,92 @@
+// Leaf node clock drift compensation.
+
+#include <Arduino.h>
+
+#include "time_sync.h"
+
+/**
+ * @brief Forget all samples
+ * @param ts The time sync state
+ */
+void init_time_sync(time_sync_t *ts) {
+    ts->first_local = 0;
+    ts->first_offset = 0;
+    ts->last_local = 0;
+    ts->last_time = 0;
+    ts->drift_ppm = 0;
+    ts->error_ppm = TIME_SYNC_DEFAULT_PPM;
+    ts->samples = 0;
+}
+
+/**
+ * @brief Add a sample of the main node's time
+ * @param ts The time sync state
+ * @param local The RTC time when the message arrived, seconds
+ * @param time The main node's time from the message
+ */
+void time_sync_update(time_sync_t *ts, uint32_t local, uint32_t time) {
+    int32_t offset = (int32_t)(time - local);
+
+    if (ts->samples > 0 && (int32_t)(local - ts->first_local) >= TIME_SYNC_MIN_SPAN) {
+        int32_t span = (int32_t)(local - ts->first_local);
+        int64_t drift = (int64_t)(offset - ts->first_offset) * 1000000 / span;
+
+        if (drift > TIME_SYNC_MAX_DRIFT_PPM || drift < -TIME_SYNC_MAX_DRIFT_PPM) {
+            init_time_sync(ts);
+        } else {
+            ts->drift_ppm = (int32_t)drift;
+            // 1 s over the span, from the resolution of both clocks
+            ts->error_ppm = (uint16_t)(1000000 / span + TIME_SYNC_MIN_ERROR_PPM);
+        }
+    }
+
+    if (ts->samples == 0) {
+        ts->first_local = local;
+        ts->first_offset = offset;
+    }
+
+    ts->last_local = local;
+    ts->last_time = time;
+    if (ts->samples < 255)
+        ts->samples++;
+}
+
+/**
+ * @brief The main node's time, predicted from the RTC
+ * @param ts The time sync state
+ * @param local The RTC time
+ * @return The corrected time; local if there has been no sample
+ */
+uint32_t time_sync_now(const time_sync_t *ts, uint32_t local) {
+    if (ts->samples == 0)
+        return local;
+
+    int32_t elapsed = (int32_t)(local - ts->last_local);
+    return ts->last_time + elapsed + (int32_t)((int64_t)elapsed * ts->drift_ppm / 1000000);
+}
+
+/**
+ * @brief How far off time_sync_now() may be
+ * @param ts The time sync state
+ * @param local The RTC time
+ * @return The predicted error in seconds, including 1 s for the
+ * resolution of the latest sample; 0xffffffff if there has been no sample
+ */
+uint32_t time_sync_error(const time_sync_t *ts, uint32_t local) {
+    if (ts->samples == 0)
+        return 0xffffffff;
+
+    uint32_t elapsed = local - ts->last_local;
+    return (uint32_t)((uint64_t)elapsed * ts->error_ppm / 1000000) + 1;
+}
+
+/**
+ * @brief Should the leaf ask for the time?
+ * @param ts The time sync state
+ * @param local The RTC time
+ * @param max_error The largest error the leaf will accept, seconds
+ * @return True if the predicted error is more than max_error
+ */
+bool time_sync_due(const time_sync_t *ts, uint32_t local, uint32_t max_error) {
+    return time_sync_error(ts, local) > max_error;
+}
@@ -0,0 +1,51 @@
+/**
+ * Leaf node clock drift compensation.
+ *
+ * The leaf feeds time_sync_update() the main node's time from every
+ * message that carries it (join_response, time_response, ack_bitmap)
+ * along with its own RTC reading at the moment the message arrived. The
+ * drift of the RTC is estimated over the whole span since the first
+ * sample, which keeps the estimate good even though both clocks count
+ * whole seconds, and time_sync_now() applies it. time_sync_due() says
+ * when the predicted error has grown past what the leaf can tolerate
+ * (e.g., the guard time in its transmit slot), so a time_request is sent
+ * only then.
+ *
+ * The leaf should leave its RTC alone and use time_sync_now() for the
+ * time; setting the RTC breaks the relation between the samples.
+ */
+
+#ifndef h_time_sync_h
+#define h_time_sync_h
+
+#include <Arduino.h>
+
+/// Drift assumed until there is an estimate; a typical 32 kHz crystal
+#define TIME_SYNC_DEFAULT_PPM 100
+
+/// Error allowed for in the estimate itself, e.g., from temperature
+#define TIME_SYNC_MIN_ERROR_PPM 2
+
+/// Shortest span, in seconds, that drift is estimated over
+#define TIME_SYNC_MIN_SPAN 3600
+
+/// A larger drift means one of the clocks was reset; start over
+#define TIME_SYNC_MAX_DRIFT_PPM 1000
+
+struct time_sync_t {
+    uint32_t first_local;   // RTC time of the first sample
+    int32_t first_offset;   // main node time - RTC time, first sample
+    uint32_t last_local;    // RTC time of the latest sample
+    uint32_t last_time;     // main node time of the latest sample
+    int32_t drift_ppm;      // RTC error, + == the RTC is slow
+    uint16_t error_ppm;     // uncertainty of drift_ppm
+    uint8_t samples;        // 0 == never synced, saturates at 255
+};
+
+void init_time_sync(time_sync_t *ts);
+void time_sync_update(time_sync_t *ts, uint32_t local, uint32_t time);
+uint32_t time_sync_now(const time_sync_t *ts, uint32_t local);
+uint32_t time_sync_error(const time_sync_t *ts, uint32_t local);
+bool time_sync_due(const time_sync_t *ts, uint32_t local, uint32_t max_error);
+
+#endif
@@ -0,0 +1,187 @@
+// Section timing and the timing report message.
+
+#include <Arduino.h>
+
+#include "timing.h"
+
+#ifdef TIMING_USE_DWT
+#define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA (1u << 24)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define DWT_CTRL_CYCCNTENA 1u
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#endif
+
+/**
+ * @brief Clear all sections and start the cycle counter, if there is one
+ * @param timing The timings
+ */
+void init_timing(timing_t *timing) {
+    memset(timing, 0, sizeof(timing_t));
+    for (uint8_t i = 0; i < TIMING_SECTIONS; ++i)
+        timing->sections[i].min = 0xffffffff;
+
+#ifdef TIMING_USE_DWT
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+/**
+ * @brief Mark the start of a section
+ * @return An opaque start time to pass to timing_stop()
+ */
+uint32_t timing_start() {
+#ifdef TIMING_USE_DWT
+    return DWT_CYCCNT;
+#else
+    return micros();
+#endif
+}
+
+/**
+ * @brief Mark the end of a section and record its time
+ * @param timing The timings
+ * @param section The section
+ * @param start The value timing_start() returned
+ */
+void timing_stop(timing_t *timing, TimingSection section, uint32_t start) {
+#ifdef TIMING_USE_DWT
+    timing_record(timing, section, (DWT_CYCCNT - start) / (F_CPU / 1000000));
+#else
+    timing_record(timing, section, micros() - start);
+#endif
+}
+
+/**
+ * @brief Record a time measured some other way
+ * @param timing The timings
+ * @param section The section
+ * @param us The time in microseconds
+ */
+void timing_record(timing_t *timing, TimingSection section, uint32_t us) {
+    if (section >= TIMING_SECTIONS)
+        return;
+
+    timing_stats_t *s = &timing->sections[section];
+    s->count++;
+    s->total += us;
+    if (us < s->min)
+        s->min = us;
+    if (us > s->max)
+        s->max = us;
+}
+
+/**
+ * @brief The mean time of a section
+ * @param stats The section's stats
+ * @return The mean in microseconds; 0 if the section has not run.
+ */
+uint32_t timing_mean(const timing_stats_t *stats) {
+    return stats->count ? (uint32_t)(stats->total / stats->count) : 0;
+}
+
+/**
+ * @brief Get the name for a TimingSection
+ */
+const char *get_timing_section_string(TimingSection section) {
+    switch (section) {
+        case timing_build:
+            return "build";
+        case timing_encode:
+            return "encode";
+        case timing_tx:
+            return "tx";
+        case timing_rx:
+            return "rx";
+        case timing_parse:
+            return "parse";
+        case timing_log:
+            return "log";
+
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief Build a timing report message
+ * @param report The message
+ * @param node The node number of the sender
+ * @param timing The timings to report
+ */
+void build_timing_report(timing_report_t *report, uint8_t node, const timing_t *timing) {
+    report->type = timing_report;
+    report->node = node;
+    for (uint8_t i = 0; i < TIMING_SECTIONS; ++i) {
+        const timing_stats_t *s = &timing->sections[i];
+        timing_report_entry_t *e = &report->sections[i];
+        e->count = (s->count > 0xffff) ? 0xffff : (uint16_t)s->count;
+        e->min = s->count ? s->min : 0;
+        e->max = s->max;
+        e->mean = timing_mean(s);
+    }
+}
+
+/**
+ * @brief extract information from a timing report message
+ * @param report The received message
+ * @param len The number of bytes received, including any CRC trailer
+ * @param node If not null, returns the node number of the sender
+ * @param sections If not null, returns the TIMING_SECTIONS entries
+ * @return true if this is a timing_report message, false otherwise.
+ */
+bool parse_timing_report(const timing_report_t *report, uint8_t len, uint8_t *node, timing_report_entry_t *sections) {
+    if (!check_message_frame(report, len, TIMING_REPORT_SIZE) || get_message_type(report) != timing_report)
+        return false;
+
+    if (node)
+        *node = report->node;
+    if (sections)
+        memcpy(sections, report->sections, sizeof(report->sections));
+
+    return true;
+}
+
+/**
+ * @brief Write a string representation for a timing report message
+ * @param report The message
+ * @param buf Destination for the string, always null terminated
+ * @param len The size of buf
+ * @param pretty True == print a verbose version, false == just the field values
+ * @return The number of characters written, not counting the null.
+ */
+size_t timing_report_to_string(const timing_report_t *report, char *buf, size_t len, bool pretty /*false*/) {
+    if (len == 0)
+        return 0;
+
+    int m = snprintf(buf, len, pretty ? "node: %u" : "%u", report->node);
+    if (m < 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+
+    // Each snprintf() result is checked before it is added, and the sum is
+    // kept in a size_t so it cannot overflow the way an int could
+    size_t n = (size_t)m;
+    for (uint8_t i = 0; i < TIMING_SECTIONS && n < len; ++i) {
+        const timing_report_entry_t *e = &report->sections[i];
+        if (pretty) {
+            m = snprintf(buf + n, len - n, ", %s: %u runs, min %lu us, mean %lu us, max %lu us",
+                         get_timing_section_string((TimingSection)i), e->count, (unsigned long)e->min,
+                         (unsigned long)e->mean, (unsigned long)e->max);
+        }
+        else {
+            m = snprintf(buf + n, len - n, ", %u, %lu, %lu, %lu", e->count, (unsigned long)e->min,
+                         (unsigned long)e->mean, (unsigned long)e->max);
+        }
+        if (m < 0) {
+            buf[n] = '\0';
+            break;
+        }
+        n += (size_t)m;
+    }
+
+    return (n < len) ? n : len - 1;
+}
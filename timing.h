@@ -0,0 +1,89 @@
+/**
+ * Timing instrumentation for the radio and codec paths.
+ *
+ * Each named section keeps a count and the min, max and total time in
+ * microseconds. Time is read from the DWT cycle counter on Cortex-M3/M4
+ * boards (e.g., SAMD51) and from micros() elsewhere (the SAMD21's M0+
+ * does not have one).
+ *
+ * @code
+ * uint32_t start = timing_start();
+ * rf95.send(buf, len);
+ * rf95.waitPacketSent();
+ * timing_stop(&timing, timing_tx, start);
+ * @endcode
+ *
+ * A leaf can send its timings to the main node in a timing_report_t.
+ */
+
+#ifndef h_timing_h
+#define h_timing_h
+
+#include <Arduino.h>
+
+#include "wire_format.h"
+#include "messages.h"
+
+#if (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)) && defined(F_CPU)
+#define TIMING_USE_DWT 1
+#endif
+
+enum TimingSection {
+    timing_build = 0,
+    timing_encode = 1,
+    timing_tx = 2,
+    timing_rx = 3,
+    timing_parse = 4,
+    timing_log = 5,
+};
+
+#define TIMING_SECTIONS 6
+
+struct timing_stats_t {
+    uint32_t count;
+    uint32_t min;       // microseconds
+    uint32_t max;
+    uint64_t total;     // a uint32_t would wrap after 4295 s, a few weeks of SF12 sends
+};
+
+struct timing_t {
+    timing_stats_t sections[TIMING_SECTIONS];
+};
+
+void init_timing(timing_t *timing);
+uint32_t timing_start();
+void timing_stop(timing_t *timing, TimingSection section, uint32_t start);
+void timing_record(timing_t *timing, TimingSection section, uint32_t us);
+uint32_t timing_mean(const timing_stats_t *stats);
+const char *get_timing_section_string(TimingSection section);
+
+/// Size of the timing report in bytes
+#define TIMING_REPORT_SIZE sizeof(timing_report_t)
+
+/**
+ * One section in a timing report. Times are in microseconds.
+ */
+struct timing_report_entry_t {
+    uint16_t count;     // saturates at 65535
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+} PACKED;
+
+/**
+ * A leaf node's timings, sent to the main node now and then.
+ */
+struct timing_report_t {
+    MessageType type;   // timing_report
+    uint8_t node;       // From
+    timing_report_entry_t sections[TIMING_SECTIONS];
+} PACKED;
+
+static_assert(TIMING_REPORT_SIZE == 86, "timing_report_t wire layout changed");
+
+void build_timing_report(timing_report_t *report, uint8_t node, const timing_t *timing);
+bool parse_timing_report(const timing_report_t *report, uint8_t len, uint8_t *node,
+                         timing_report_entry_t *sections /* TIMING_SECTIONS */);
+size_t timing_report_to_string(const timing_report_t *report, char *buf, size_t len, bool pretty = false);
+
+#endif
@@ -0,0 +1,43 @@
+// Varint encode and decode functions.
+
+#include <Arduino.h>
+
+#include "varint.h"
+
+/**
+ * @brief Write a varint
+ * @param buf Destination, must have room for VARINT_MAX_LEN bytes
+ * @param value The value to write
+ * @return The number of bytes written, 1 to VARINT_MAX_LEN
+ */
+uint8_t put_varint(uint8_t *buf, uint32_t value) {
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        buf[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (uint8_t)value;
+
+    return n;
+}
+
+/**
+ * @brief Read a varint
+ * @param buf Source bytes
+ * @param len The number of bytes available in buf
+ * @param value V-R parameter for the decoded value
+ * @return The number of bytes read, or 0 if buf does not hold a
+ * complete varint of at most VARINT_MAX_LEN bytes.
+ */
+uint8_t get_varint(const uint8_t *buf, uint8_t len, uint32_t *value) {
+    uint32_t v = 0;
+    for (uint8_t n = 0; n < len && n < VARINT_MAX_LEN; ++n) {
+        v |= (uint32_t)(buf[n] & 0x7f) << (7 * n);
+        if (!(buf[n] & 0x80)) {
+            *value = v;
+            return n + 1;
+        }
+    }
+
+    return 0;
+}
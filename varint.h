@@ -0,0 +1,30 @@
+/**
+ * Variable length integer encoding used by the compact message
+ * formats. Values are written seven bits at a time, least significant
+ * group first, with the high bit of each byte set when more bytes
+ * follow. Signed values are zig-zag mapped first so that small
+ * negative numbers stay short.
+ */
+
+#ifndef h_varint_h
+#define h_varint_h
+
+#include <Arduino.h>
+
+/// The most bytes put_varint() will write for a 32-bit value
+#define VARINT_MAX_LEN 5
+
+/// Map a signed value onto an unsigned one: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+inline uint32_t zigzag_encode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/// Inverse of zigzag_encode()
+inline int32_t zigzag_decode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+uint8_t put_varint(uint8_t *buf, uint32_t value);
+uint8_t get_varint(const uint8_t *buf, uint8_t len, uint32_t *value);
+
+#endif
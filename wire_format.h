@@ -0,0 +1,56 @@
+/**
+ * Wire format definitions shared by all of the messages sent between
+ * the leaf and main nodes.
+ *
+ * Every message is a packed struct: no compiler padding, one-byte
+ * alignment and multi-byte fields stored little-endian. The structs
+ * are sent as-is by the radio, so the layout of each one is the
+ * layout on the air. Both the SAMD (ARM) and AVR nodes are little-endian;
+ * the check below keeps a big-endian build from silently sending
+ * byte-swapped fields.
+ *
+ * The get_le*() functions read a field straight out of a receive
+ * buffer. They read one byte at a time, so they are safe at any
+ * alignment.
+ *
+ * written_length() is shared by the *_to_string() functions of every
+ * message.
+ */
+
+#ifndef h_wire_format_h
+#define h_wire_format_h
+
+#include <Arduino.h>
+#include <stddef.h>
+
+/// Pack a struct so that its in-memory layout is its wire layout.
+#define PACKED __attribute__((packed))
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "The soil sensor wire format requires a little-endian target"
+#endif
+
+inline uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t get_le64(const uint8_t *p) {
+    return (uint64_t)get_le32(p) | ((uint64_t)get_le32(p + 4) << 32);
+}
+
+/**
+ * @brief The number of characters snprintf() actually wrote
+ * @param n The value returned by snprintf()
+ * @param len The size of the buffer passed to snprintf()
+ */
+inline size_t written_length(int n, size_t len) {
+    if (n < 0 || len == 0)
+        return 0;
+    return ((size_t)n < len) ? (size_t)n : len - 1;
+}
+
+#endif